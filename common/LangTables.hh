@@ -22,148 +22,213 @@
 
 namespace LangTables {
 
+struct Language {
+	const char* prefix;
+	const char* code;
+	const char* name;
+};
+
+// Sorted by prefix, see findLanguage
+static constexpr Language LANGUAGES[] = {
+	// See https://en.wikipedia.org/wiki/List_of_language_names
+	// {ISO 639-2, ISO 639-1, name}
+	//
+	// An easy way to generate the strings below:
+	// echo "עברית (רש״י)" | uni2ascii -a U -q
+	// Verify:
+	// echo "\u05E2\u05D1\u05E8\u05D9\u05EA (\u05E8\u05E9\u05F4\u05D9)" | ascii2uni  -a U -q
+	{"afr",      "af", "Afrikaans"}, // Afrikaans
+	{"amh",      "am", "\u12A3\u121B\u122D\u129B"}, // Amharic
+	{"ara",      "ar", "\u0627\u0644\u0644\u063A\u0629 \u0627\u0644\u0639\u0631\u0628\u064A\u0629"}, // Arabic
+	{"asm",      "as", "\u0985\u09B8\u09AE\u09C0\u09AF\u09BC\u09BE"}, // Assamese
+	{"aze",      "az", "\u0622\u0630\u0631\u0628\u0627\u06CC\u062C\u0627\u0646 \u062F\u06CC\u0644\u06CC"}, // Azerbaijani
+	{"aze_cyrl", "az", "Az\u0259rbaycanca"}, // Azerbaijani (Cyrillic)
+	{"bel",      "be", "\u0411\u0435\u043B\u0430\u0440\u0443\u0441\u043A\u0430\u044F"}, // Belarusian
+	{"ben",      "bn", "\u09AC\u09BE\u0982\u09B2\u09BE"}, // Bengali
+	{"bod",      "bo", "\u0F51\u0F56\u0F74\u0F66\u0F0B\u0F66\u0F90\u0F51\u0F0B"}, // "Tibetan (Standard)"
+	{"bos",      "bs", "Bosanski"}, // Bosnian
+	{"bre",      "bs", "Brezhoneg"}, // Breton
+	{"bul",      "bg", "\u0431\u044A\u043B\u0433\u0430\u0440\u0441\u043A\u0438 \u0435\u0437\u0438\u043A"}, // Bulgarian
+	{"cat",      "ca", "Catal\u00E0"}, // Catalan
+	{"ceb",      "",   "Bisaya"}, // Cebuano
+	{"ces",      "cs", "\u010Ce\u0161tina"}, // Czech
+	{"chi_sim",  "zh_CN", "\u7b80\u4f53\u5b57 "}, // Chinese (Simplified)
+	{"chi_sim_vert",  "zh_CN", "\u7b80\u4f53\u5b57 \u7EB5"}, // Chinese (Simplified, Vertical)
+	{"chi_tra",  "zh_TW", "\u7e41\u9ad4\u5b57"}, // Chinese (Traditional)
+	{"chi_tra_vert",  "zh_TW", "\u7e41\u9ad4\u5b57 \u7EB5"}, // Chinese (Traditional, Vertical)
+	{"chr",      "",   "\u13E3\u13B3\u13A9"}, // Cherokee
+	{"cos",      "co", "Corsu"}, // Corsican
+	{"cym",      "cy", "Cymraeg"}, // Welsh
+	{"dan",      "da", "Dansk"}, // Danish
+	{"dan_frak", "da", "Dansk (Fraktur)"}, // Danish (Fraktur)
+	{"deu",      "de", "Deutsch"}, // German
+	{"deu_frak", "de", "Deutsch (Fraktur)"}, // German (Fraktur)
+	{"div",      "dv", "\u078B\u07A8\u0788\u07AC\u0780\u07A8"}, // Dhivehi
+	{"dzo",      "dz", "\u0F62\u0FAB\u0F7C\u0F44\u0F0B\u0F41\u0F0B"}, // Dzongkha
+	{"ell",      "el", "\u0395\u03BB\u03BB\u03B7\u03BD\u03B9\u03BA\u03AC"}, // Greek
+	{"eng",      "en", "English"},
+	{"enm",      "en", "Middle English (1100-1500)"}, // Middle English (1100-1500)
+	{"epo",      "eo", "Esperanto"}, // Esperanto
+	{"equ",      "",   "Math / Equations"}, // Math / equation
+	{"est",      "et", "Eesti"}, // Estonian
+	{"eus",      "eu", "Euskara"}, // Basque
+	{"fao",      "fo", "F\u00F8royskt"}, // Faroese
+	{"fas",      "fa", "\u0641\u0627\u0631\u0633\u06CC"}, // Persian (Farsi)
+	{"fil",      "",   "Wikang Filipino"}, // Filipino
+	{"fin",      "fi", "Suomi"}, // Finnish
+	{"fra",      "fr", "Fran\u00E7ais"}, // French
+	{"frk",      "",   "Frankish"}, // Frankish
+	{"frm",      "fr", "Moyen fran\u00E7ais (ca. 1400-1600)"}, // Middle French (ca. 1400-1600)
+	{"fry",      "fy", "Frysk"}, // Frisian (West)
+	{"gla",      "gd", "G\u00E0idhlig"}, // Scottish Gaelic
+	{"gle",      "ga", "Gaeilge"}, // Irish
+	{"glg",      "gl", "Galego"}, // Galician
+	{"grc",      "el", "\u1f19\u03bb\u03bb\u03b7\u03bd\u03b9\u03ba\u03ae"}, // Ancient Greek
+	{"guj",      "gu", "\u0A97\u0AC1\u0A9C\u0AB0\u0ABE\u0AA4\u0AC0"}, // Gujarati
+	{"hat",      "ht", "Krey\u00F2l Ayisyen"}, // Haitian
+	{"heb",      "he", "\u05E2\u05D1\u05E8\u05D9\u05EA"}, // Hebrew
+	{"heb_rashi", "he", "\u05E2\u05D1\u05E8\u05D9\u05EA (\u05E8\u05E9\u05F4\u05D9)"}, // Hebrew (Toranit, Rashi Script)
+	{"heb_toranit", "he", "\u05E2\u05D1\u05E8\u05D9\u05EA (\u05EA\u05D5\u05E8\u05E0\u05D9\u05EA)"}, // Hebrew (Toranit)
+	{"hin",      "hi", "\u0939\u093F\u0928\u094D\u0926\u0940"}, // Hindi
+	{"hrv",      "hr", "Hrvatski"}, // Croatian
+	{"hun",      "hu", "Magyar"}, // Hungarian
+	{"hye",      "hy", "\u0540\u0561\u0575\u0565\u0580\u0565\u0576"}, // Armenian
+	{"iku",      "iu", "\u1403\u14C4\u1483\u144E\u1450\u1466"}, // Inuktitut
+	{"ind",      "id", "Bahasa Indonesia"}, // Indonesian
+	{"isl",      "is", "\u00CDslenska"}, // Icelandic
+	{"ita",      "it", "Italiano"}, // Italian
+	{"ita_old",  "it", "Italiano (Antico)"}, // Italian (Old)
+	{"jav",      "jv", "Basa jawa"}, // Javanese
+	{"jpn",      "ja", "\u65E5\u672C\u8A9E"}, // Japanese
+	{"jpn_vert", "ja", "\u65E5\u672C\u8A9E \u7E26\u66F8\u304D"}, // Japanese (Vertical)
+	{"kan",      "kn", "\u0C95\u0CA8\u0CCD\u0CA8\u0CA1"}, // Kannada
+	{"kat",      "ka", "\u10E5\u10D0\u10E0\u10D7\u10E3\u10DA\u10D8"}, // Georgian
+	{"kat_old",  "ka", "\u10d4\u10dc\u10d0\u10f2 \u10e5\u10d0\u10e0\u10d7\u10e3\u10da\u10d8"}, // Georgian (Old)
+	{"kaz",      "kk", "\u049A\u0430\u0437\u0430\u049B T\u0456\u043B\u0456"}, // Kazakh
+	{"khm",      "km", "\u1797\u17B6\u179F\u17B6\u1781\u17D2\u1798\u17C2\u179A"}, // Khmer
+	{"kir",      "ky", "\u041a\u044b\u0440\u0433\u044b\u0437\u0447\u0430"}, // Kyrgyz
+	{"kor",      "ko", "\uD55C\uAD6D\uC5B4"}, // Korean
+	{"kor_vert", "ko", "\uD55C\uAD6D\uC5B4 \uC218\uC9C1\uC120"}, // Korean (Vertical)
+	{"kur",      "ku", "Kurd\u00ED"}, // Kurdish
+	{"kur_ara",  "ku", "\u06A9\u0648\u0631\u062F\u06CC"}, // Kurdish (Arabic)
+	{"lao",      "lo", "\u0E9E\u0EB2\u0EAA\u0EB2\u0EA5\u0EB2\u0EA7"}, // Lao
+	{"lat",      "la", "Latina"}, // Latin
+	{"lav",      "lv", "Latvie\u0161u"}, // Latvian
+	{"lit",      "lt", "Lietuvi\u0173"}, // Lithuanian
+	{"ltz",      "lb", "L\u00EBtzebuergesch"}, // Luxembourgish
+	{"mal",      "ml", "\u0D2E\u0D32\u0D2F\u0D3E\u0D33\u0D02"}, // Malayalam
+	{"mar",      "mr", "\u092E\u0930\u093E\u0920\u0940"}, // Marathi
+	{"mkd",      "mk", "M\u0430\u043A\u0435\u0434\u043E\u043D\u0441\u043A\u0438"}, // Macedonian
+	{"mlt",      "mt", "Malti"}, // Maltese
+	{"mon",      "mn", "\u041C\u043E\u043D\u0433\u043E\u043B \u0425\u044D\u043B"}, // Mongolian
+	{"mri",      "mi", "te Reo M\u0101ori"}, // Maori
+	{"msa",      "ms", "Bahasa Melayu"}, // Malay
+	{"mya",      "my", "\u1019\u103C\u1014\u103A\u1019\u102C\u1005\u102C"}, // Burmese
+	{"nep",      "ne", "\u0928\u0947\u092A\u093E\u0932\u0940"}, // Nepali
+	{"nld",      "nl", "Nederlands"}, // Dutch
+	{"nor",      "no", "Norsk"}, // Norwegian
+	{"oci",      "oc", "Occitan"}, // Occitan
+	{"ori",      "or", "\u0b13\u0b21\u0b3c\u0b3f\u0b06"}, // Oriya
+	{"pan",      "pa", "\u0A2A\u0A70\u0A1C\u0A3E\u0A2C\u0A40"}, // Punjabi
+	{"pol",      "pl", "Polski"}, // Polish
+	{"por",      "pt", "Portugu\u00EAs"}, // Portuguese
+	{"pus",      "ps", "\u067E\u069A\u062A\u0648"}, // Pashto
+	{"que",      "qu", "Runasimi"}, // Quechuan
+	{"ron",      "ro", "Rom\u00E2n\u0103"}, // Romanian
+	{"rus",      "ru", "\u0420\u0443\u0441\u0441\u043A\u0438\u0439"}, // Russian
+	{"san",      "sa", "\u0938\u0902\u0938\u094D\u0915\u0943\u0924\u092E\u094D"}, // Sanskrit
+	{"sin",      "si", "\u0DC3\u0DD2\u0D82\u0DC4\u0DBD"}, // Sinhala
+	{"slk",      "sk", "Sloven\u010Dina"}, // Slovak
+	{"slk_frak", "sk", "Sloven\u010Dina (Frakt\u00far)"}, // Slovak (Fraktur)
+	{"slv",      "sl", "Sloven\u0161\u010Dina"}, // Slovene
+	{"snd",      "sd", "\u0633\u0646\u068C\u064A"}, // Sindhi
+	{"spa",      "es", "Espa\u00F1ol"}, // Spanish
+	{"spa_old",  "es", "Espa\u00F1ol (Antiguo)"}, // Spanish (Old)
+	{"sqi",      "sq", "Shqip"}, // Albanian
+	{"srp",      "sr", "\u0421\u0440\u043F\u0441\u043A\u0438"}, // Serbian
+	{"srp_latn", "sr", "Srpski"}, // Serbian (Latin)
+	{"sun",      "su", "\u1B98\u1B9E \u1B9E\u1BA5\u1B94\u1BAA\u1B93"}, // Sundanese
+	{"swa",      "sw", "Kiswahili"}, // Swahili
+	{"swe",      "sv", "Svenska"}, // Swedish
+	{"syr",      "",   "\u0720\u072b\u0722\u0710 \u0723\u0718\u072a\u071d\u071d\u0710"}, // Syriac
+	{"tam",      "ta", "\u0BA4\u0BAE\u0BBF\u0BB4\u0BCD"}, // Tamil
+	{"tat",      "tt", "Tatar\u00E7a"}, // Tatar
+	{"tel",      "te", "\u0C24\u0C46\u0C32\u0C41\u0C17\u0C41"}, // Telugu
+	{"tgk",      "tg", "\u0442\u043e\u04b7\u0438\u043a\u04e3"}, // Tajik
+	{"tgl",      "tl", "\u170A\u170A\u170C\u1712"}, // Tagalog
+	{"tha",      "th", "\u0E20\u0E32\u0E29\u0E32\u0E44\u0E17\u0E22"}, // Thai
+	{"tir",      "ti", "\u1275\u130D\u122D\u129B"}, // Tigrinya
+	{"ton",      "to", "Lea faka-Tonga"}, // Tongan
+	{"tur",      "tr", "T\u00FCrk\u00E7e"}, // Turkish
+	{"uig",      "ug", "\u0626\u06C7\u064A\u063A\u06C7\u0631 \u062A\u0649\u0644\u0649"}, // Uyghur
+	{"ukr",      "uk", "\u0423\u043A\u0440\u0430\u0457\u043D\u0441\u044C\u043A\u0430"}, // Ukrainian
+	{"urd",      "ur", "\u0627\u064F\u0631\u062F\u064F\u0648"}, // Urdu
+	{"uzb",      "uz", "\u0627\u0648\u0632\u0628\u06CC\u06A9"}, // Uzbek
+	{"uzb_cyrl", "uz", "\u040E\u0437\u0431\u0435\u043A"}, // Uzbek (Cyrillic)
+	{"vie",      "vi", "Ti\u1EBFng Vi\u1EC7t Nam"}, // Vietnamese
+	{"yid",      "yi", "\u05D9\u05D9\u05B4\u05D3\u05D9\u05E9 \u05D9\u05D9\u05B4\u05D3\u05D9\u05E9\u202C"}, // Yiddish
+	{"yor",      "yo", "\u00C8d\u00E8 Yor\u00F9b\u00E1"}, // Yoruba
+};
+
+static constexpr int LANGUAGE_COUNT = sizeof(LANGUAGES) / sizeof(LANGUAGES[0]);
+
+constexpr int compareAscii(const char* a, const char* b) {
+	while(*a && *a == *b) {
+		++a;
+		++b;
+	}
+	return int(static_cast<unsigned char>(*a)) - int(static_cast<unsigned char>(*b));
+}
+
+constexpr bool languagesSorted() {
+	for(int i = 1; i < LANGUAGE_COUNT; ++i) {
+		if(compareAscii(LANGUAGES[i - 1].prefix, LANGUAGES[i].prefix) >= 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(languagesSorted(), "LangTables::LANGUAGES must be sorted by prefix");
+
+// Binary search of the table, compare(prefix) returns the sign of the searched key compared to prefix
+template<class Compare>
+constexpr int findLanguage(Compare compare) {
+	int lo = 0, hi = LANGUAGE_COUNT;
+	while(lo < hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = compare(LANGUAGES[mid].prefix);
+		if(cmp == 0) {
+			return mid;
+		} else if(cmp < 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+	return -1;
+}
+
+struct PrefixCompare {
+	const char* key;
+	constexpr int operator()(const char* prefix) const {
+		return compareAscii(key, prefix);
+	}
+};
+
+constexpr int languageIndex(const char* prefix) {
+	return findLanguage(PrefixCompare{prefix});
+}
+
+static_assert(languageIndex("afr") == 0 && languageIndex("eng") > 0 && languageIndex("xxx") < 0, "LangTables::findLanguage is broken");
+
 template<class Container, class String>
 Container languages(const std::function<String(const char*)>& utf8str) {
-	return Container {
-		// See https://en.wikipedia.org/wiki/List_of_language_names
-		// {ISO 639-2, ISO 639-1, name}
-		//
-		// An easy way to generate the strings below:
-		// echo "עברית (רש״י)" | uni2ascii -a U -q
-		// Verify:
-		// echo "\u05E2\u05D1\u05E8\u05D9\u05EA (\u05E8\u05E9\u05F4\u05D9)" | ascii2uni  -a U -q
-		{"afr",      "af", utf8str("Afrikaans")}, // Afrikaans
-		{"amh",      "am", utf8str("\u12A3\u121B\u122D\u129B")}, // Amharic
-		{"ara",      "ar", utf8str("\u0627\u0644\u0644\u063A\u0629 \u0627\u0644\u0639\u0631\u0628\u064A\u0629")}, // Arabic
-		{"asm",      "as", utf8str("\u0985\u09B8\u09AE\u09C0\u09AF\u09BC\u09BE")}, // Assamese
-		{"aze",      "az", utf8str("\u0622\u0630\u0631\u0628\u0627\u06CC\u062C\u0627\u0646 \u062F\u06CC\u0644\u06CC")}, // Azerbaijani
-		{"aze_cyrl", "az", utf8str("Az\u0259rbaycanca")}, // Azerbaijani (Cyrillic)
-		{"bel",      "be", utf8str("\u0411\u0435\u043B\u0430\u0440\u0443\u0441\u043A\u0430\u044F")}, // Belarusian
-		{"ben",      "bn", utf8str("\u09AC\u09BE\u0982\u09B2\u09BE")}, // Bengali
-		{"bod",      "bo", utf8str("\u0F51\u0F56\u0F74\u0F66\u0F0B\u0F66\u0F90\u0F51\u0F0B")}, // "Tibetan (Standard)"
-		{"bos",      "bs", utf8str("Bosanski")}, // Bosnian
-		{"bre",      "bs", utf8str("Brezhoneg")}, // Breton
-		{"bul",      "bg", utf8str("\u0431\u044A\u043B\u0433\u0430\u0440\u0441\u043A\u0438 \u0435\u0437\u0438\u043A")}, // Bulgarian
-		{"cat",      "ca", utf8str("Catal\u00E0")}, // Catalan
-		{"ceb",      "",   utf8str("Bisaya")}, // Cebuano
-		{"ces",      "cs", utf8str("\u010Ce\u0161tina")}, // Czech
-		{"chi_sim",  "zh_CN", utf8str("\u7b80\u4f53\u5b57 ")}, // Chinese (Simplified)
-		{"chi_sim_vert",  "zh_CN", utf8str("\u7b80\u4f53\u5b57 \u7EB5")}, // Chinese (Simplified, Vertical)
-		{"chi_tra",  "zh_TW", utf8str("\u7e41\u9ad4\u5b57")}, // Chinese (Traditional)
-		{"chi_tra_vert",  "zh_TW", utf8str("\u7e41\u9ad4\u5b57 \u7EB5")}, // Chinese (Traditional, Vertical)
-		{"chr",      "",   utf8str("\u13E3\u13B3\u13A9")}, // Cherokee
-		{"cos",      "co", utf8str("Corsu")}, // Corsican
-		{"cym",      "cy", utf8str("Cymraeg")}, // Welsh
-		{"dan",      "da", utf8str("Dansk")}, // Danish
-		{"dan_frak", "da", utf8str("Dansk (Fraktur)")}, // Danish (Fraktur)
-		{"deu",      "de", utf8str("Deutsch")}, // German
-		{"deu_frak", "de", utf8str("Deutsch (Fraktur)")}, // German (Fraktur)
-		{"div",      "dv", utf8str("\u078B\u07A8\u0788\u07AC\u0780\u07A8")}, // Dhivehi
-		{"dzo",      "dz", utf8str("\u0F62\u0FAB\u0F7C\u0F44\u0F0B\u0F41\u0F0B")}, // Dzongkha
-		{"ell",      "el", utf8str("\u0395\u03BB\u03BB\u03B7\u03BD\u03B9\u03BA\u03AC")}, // Greek
-		{"eng",      "en", utf8str("English")},
-		{"enm",      "en", utf8str("Middle English (1100-1500)")}, // Middle English (1100-1500)
-		{"epo",      "eo", utf8str("Esperanto")}, // Esperanto
-		{"equ",      "",   utf8str("Math / Equations")}, // Math / equation
-		{"est",      "et", utf8str("Eesti")}, // Estonian
-		{"eus",      "eu", utf8str("Euskara")}, // Basque
-		{"fas",      "fa", utf8str("\u0641\u0627\u0631\u0633\u06CC")}, // Persian (Farsi)
-		{"fao",      "fo", utf8str("F\u00F8royskt")}, // Faroese
-		{"fil",      "",   utf8str("Wikang Filipino")}, // Filipino
-		{"fin",      "fi", utf8str("Suomi")}, // Finnish
-		{"fra",      "fr", utf8str("Fran\u00E7ais")}, // French
-		{"frk",      "",   utf8str("Frankish")}, // Frankish
-		{"frm",      "fr", utf8str("Moyen fran\u00E7ais (ca. 1400-1600)")}, // Middle French (ca. 1400-1600)
-		{"fry",      "fy", utf8str("Frysk")}, // Frisian (West)
-		{"gla",      "gd", utf8str("G\u00E0idhlig")}, // Scottish Gaelic
-		{"gle",      "ga", utf8str("Gaeilge")}, // Irish
-		{"glg",      "gl", utf8str("Galego")}, // Galician
-		{"grc",      "el", utf8str("\u1f19\u03bb\u03bb\u03b7\u03bd\u03b9\u03ba\u03ae")}, // Ancient Greek
-		{"guj",      "gu", utf8str("\u0A97\u0AC1\u0A9C\u0AB0\u0ABE\u0AA4\u0AC0")}, // Gujarati
-		{"hat",      "ht", utf8str("Krey\u00F2l Ayisyen")}, // Haitian
-		{"heb",      "he", utf8str("\u05E2\u05D1\u05E8\u05D9\u05EA")}, // Hebrew
-		{"heb_rashi", "he", utf8str("\u05E2\u05D1\u05E8\u05D9\u05EA (\u05E8\u05E9\u05F4\u05D9)")}, // Hebrew (Toranit, Rashi Script)
-		{"heb_toranit", "he", utf8str("\u05E2\u05D1\u05E8\u05D9\u05EA (\u05EA\u05D5\u05E8\u05E0\u05D9\u05EA)")}, // Hebrew (Toranit)
-		{"hin",      "hi", utf8str("\u0939\u093F\u0928\u094D\u0926\u0940")}, // Hindi
-		{"hrv",      "hr", utf8str("Hrvatski")}, // Croatian
-		{"hun",      "hu", utf8str("Magyar")}, // Hungarian
-		{"hye",      "hy", utf8str("\u0540\u0561\u0575\u0565\u0580\u0565\u0576")}, // Armenian
-		{"iku",      "iu", utf8str("\u1403\u14C4\u1483\u144E\u1450\u1466")}, // Inuktitut
-		{"ind",      "id", utf8str("Bahasa Indonesia")}, // Indonesian
-		{"isl",      "is", utf8str("\u00CDslenska")}, // Icelandic
-		{"ita",      "it", utf8str("Italiano")}, // Italian
-		{"ita_old",  "it", utf8str("Italiano (Antico)")}, // Italian (Old)
-		{"jav",      "jv", utf8str("Basa jawa")}, // Javanese
-		{"jpn",      "ja", utf8str("\u65E5\u672C\u8A9E")}, // Japanese
-		{"jpn_vert", "ja", utf8str("\u65E5\u672C\u8A9E \u7E26\u66F8\u304D")}, // Japanese (Vertical)
-		{"kan",      "kn", utf8str("\u0C95\u0CA8\u0CCD\u0CA8\u0CA1")}, // Kannada
-		{"kat",      "ka", utf8str("\u10E5\u10D0\u10E0\u10D7\u10E3\u10DA\u10D8")}, // Georgian
-		{"kat_old",  "ka", utf8str("\u10d4\u10dc\u10d0\u10f2 \u10e5\u10d0\u10e0\u10d7\u10e3\u10da\u10d8")}, // Georgian (Old)
-		{"kaz",      "kk", utf8str("\u049A\u0430\u0437\u0430\u049B T\u0456\u043B\u0456")}, // Kazakh
-		{"khm",      "km", utf8str("\u1797\u17B6\u179F\u17B6\u1781\u17D2\u1798\u17C2\u179A")}, // Khmer
-		{"kir",      "ky", utf8str("\u041a\u044b\u0440\u0433\u044b\u0437\u0447\u0430")}, // Kyrgyz
-		{"kor",      "ko", utf8str("\uD55C\uAD6D\uC5B4")}, // Korean
-		{"kor_vert", "ko", utf8str("\uD55C\uAD6D\uC5B4 \uC218\uC9C1\uC120")}, // Korean (Vertical)
-		{"kur",      "ku", utf8str("Kurd\u00ED")}, // Kurdish
-		{"kur_ara",  "ku", utf8str("\u06A9\u0648\u0631\u062F\u06CC")}, // Kurdish (Arabic)
-		{"lao",      "lo", utf8str("\u0E9E\u0EB2\u0EAA\u0EB2\u0EA5\u0EB2\u0EA7")}, // Lao
-		{"lat",      "la", utf8str("Latina")}, // Latin
-		{"lav",      "lv", utf8str("Latvie\u0161u")}, // Latvian
-		{"lit",      "lt", utf8str("Lietuvi\u0173")}, // Lithuanian
-		{"ltz",      "lb", utf8str("L\u00EBtzebuergesch")}, // Luxembourgish
-		{"mal",      "ml", utf8str("\u0D2E\u0D32\u0D2F\u0D3E\u0D33\u0D02")}, // Malayalam
-		{"mar",      "mr", utf8str("\u092E\u0930\u093E\u0920\u0940")}, // Marathi
-		{"mkd",      "mk", utf8str("M\u0430\u043A\u0435\u0434\u043E\u043D\u0441\u043A\u0438")}, // Macedonian
-		{"mlt",      "mt", utf8str("Malti")}, // Maltese
-		{"mon",      "mn", utf8str("\u041C\u043E\u043D\u0433\u043E\u043B \u0425\u044D\u043B")}, // Mongolian
-		{"mri",      "mi", utf8str("te Reo M\u0101ori")}, // Maori
-		{"msa",      "ms", utf8str("Bahasa Melayu")}, // Malay
-		{"mya",      "my", utf8str("\u1019\u103C\u1014\u103A\u1019\u102C\u1005\u102C")}, // Burmese
-		{"nep",      "ne", utf8str("\u0928\u0947\u092A\u093E\u0932\u0940")}, // Nepali
-		{"nld",      "nl", utf8str("Nederlands")}, // Dutch
-		{"nor",      "no", utf8str("Norsk")}, // Norwegian
-		{"oci",      "oc", utf8str("Occitan")}, // Occitan
-		{"ori",      "or", utf8str("\u0b13\u0b21\u0b3c\u0b3f\u0b06")}, // Oriya
-		{"pan",      "pa", utf8str("\u0A2A\u0A70\u0A1C\u0A3E\u0A2C\u0A40")}, // Punjabi
-		{"pol",      "pl", utf8str("Polski")}, // Polish
-		{"por",      "pt", utf8str("Portugu\u00EAs")}, // Portuguese
-		{"pus",      "ps", utf8str("\u067E\u069A\u062A\u0648")}, // Pashto
-		{"que",      "qu", utf8str("Runasimi")}, // Quechuan
-		{"ron",      "ro", utf8str("Rom\u00E2n\u0103")}, // Romanian
-		{"rus",      "ru", utf8str("\u0420\u0443\u0441\u0441\u043A\u0438\u0439")}, // Russian
-		{"san",      "sa", utf8str("\u0938\u0902\u0938\u094D\u0915\u0943\u0924\u092E\u094D")}, // Sanskrit
-		{"sin",      "si", utf8str("\u0DC3\u0DD2\u0D82\u0DC4\u0DBD")}, // Sinhala
-		{"slk",      "sk", utf8str("Sloven\u010Dina")}, // Slovak
-		{"slk_frak", "sk", utf8str("Sloven\u010Dina (Frakt\u00far)")}, // Slovak (Fraktur)
-		{"slv",      "sl", utf8str("Sloven\u0161\u010Dina")}, // Slovene
-		{"snd",      "sd", utf8str("\u0633\u0646\u068C\u064A")}, // Sindhi
-		{"spa",      "es", utf8str("Espa\u00F1ol")}, // Spanish
-		{"spa_old",  "es", utf8str("Espa\u00F1ol (Antiguo)")}, // Spanish (Old)
-		{"sqi",      "sq", utf8str("Shqip")}, // Albanian
-		{"srp",      "sr", utf8str("\u0421\u0440\u043F\u0441\u043A\u0438")}, // Serbian
-		{"srp_latn", "sr", utf8str("Srpski")}, // Serbian (Latin)
-		{"sun",      "su", utf8str("\u1B98\u1B9E \u1B9E\u1BA5\u1B94\u1BAA\u1B93")}, // Sundanese
-		{"swa",      "sw", utf8str("Kiswahili")}, // Swahili
-		{"swe",      "sv", utf8str("Svenska")}, // Swedish
-		{"syr",      "",   utf8str("\u0720\u072b\u0722\u0710 \u0723\u0718\u072a\u071d\u071d\u0710")}, // Syriac
-		{"tam",      "ta", utf8str("\u0BA4\u0BAE\u0BBF\u0BB4\u0BCD")}, // Tamil
-		{"tat",      "tt", utf8str("Tatar\u00E7a")}, // Tatar
-		{"tel",      "te", utf8str("\u0C24\u0C46\u0C32\u0C41\u0C17\u0C41")}, // Telugu
-		{"tgk",      "tg", utf8str("\u0442\u043e\u04b7\u0438\u043a\u04e3")}, // Tajik
-		{"tgl",      "tl", utf8str("\u170A\u170A\u170C\u1712")}, // Tagalog
-		{"tha",      "th", utf8str("\u0E20\u0E32\u0E29\u0E32\u0E44\u0E17\u0E22")}, // Thai
-		{"tir",      "ti", utf8str("\u1275\u130D\u122D\u129B")}, // Tigrinya
-		{"ton",      "to", utf8str("Lea faka-Tonga")}, // Tongan
-		{"tur",      "tr", utf8str("T\u00FCrk\u00E7e")}, // Turkish
-		{"uig",      "ug", utf8str("\u0626\u06C7\u064A\u063A\u06C7\u0631 \u062A\u0649\u0644\u0649")}, // Uyghur
-		{"ukr",      "uk", utf8str("\u0423\u043A\u0440\u0430\u0457\u043D\u0441\u044C\u043A\u0430")}, // Ukrainian
-		{"urd",      "ur", utf8str("\u0627\u064F\u0631\u062F\u064F\u0648")}, // Urdu
-		{"uzb",      "uz", utf8str("\u0627\u0648\u0632\u0628\u06CC\u06A9")}, // Uzbek
-		{"uzb_cyrl", "uz", utf8str("\u040E\u0437\u0431\u0435\u043A")}, // Uzbek (Cyrillic)
-		{"vie",      "vi", utf8str("Ti\u1EBFng Vi\u1EC7t Nam")}, // Vietnamese
-		{"yid",      "yi", utf8str("\u05D9\u05D9\u05B4\u05D3\u05D9\u05E9 \u05D9\u05D9\u05B4\u05D3\u05D9\u05E9\u202C")}, // Yiddish
-		{"yor",      "yo", utf8str("\u00C8d\u00E8 Yor\u00F9b\u00E1")}, // Yoruba
-	};
+	Container container;
+	for(const Language& language : LANGUAGES) {
+		container.push_back({String(language.prefix), String(language.code), utf8str(language.name)});
+	}
+	return container;
 }
 
 template<class Container>
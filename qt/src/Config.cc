@@ -37,14 +37,6 @@
 #undef USE_STD_NAMESPACE
 
 const QList<Config::Lang> Config::LANGUAGES = LangTables::languages<QList<Config::Lang>, QString>([](const char* str) { return QString::fromUtf8(str); });
-const QMap<QString, QString> Config::LANG_LOOKUP = [] {
-	QMap<QString, QString> lookup;
-	for(const Config::Lang& lang : LANGUAGES) {
-		lookup.insert(lang.prefix, lang.code);
-	}
-	return lookup;
-}();
-
 const QMultiMap<QString, QString> Config::LANGUAGE_CULTURES = LangTables::languageCultures<QMultiMap<QString, QString>>();
 
 
@@ -98,24 +90,41 @@ Config::Config(QWidget* parent)
 }
 
 bool Config::searchLangSpec(Lang& lang) const {
+	return searchLangSpec(lang, langSpecs());
+}
+
+QList<Config::Lang> Config::langSpecs() const {
+	QList<Lang> langs;
+	for(const QTableWidget* table : QList<QTableWidget*> {ui.tableWidgetPredefLang, ui.tableWidgetAdditionalLang}) {
+		for(int row = 0, nRows = table->rowCount(); row < nRows; ++row) {
+			langs.append({table->item(row, 0)->text(), table->item(row, 1)->text(), table->item(row, 2)->text()});
+		}
+	}
+	return langs;
+}
+
+bool Config::searchLangSpec(Lang& lang, const QList<Lang>& langSpecs) {
 	// Tesseract 4.x up to beta.1 had script tessdatas on same level as language tessdatas, but they are distinguishable in that they begin with an upper case character
 	if(lang.prefix.startsWith("script", Qt::CaseInsensitive) || lang.prefix.left(1).toUpper() == lang.prefix.left(1)) {
 		QString name = lang.prefix.startsWith("script", Qt::CaseInsensitive) ? lang.prefix.mid(7) : lang.prefix;
 		lang.name = QString("%1 [%2]").arg(name).arg(_("Script"));
 		return true;
 	}
-	for(const QTableWidget* table : QList<QTableWidget*> {ui.tableWidgetPredefLang, ui.tableWidgetAdditionalLang}) {
-		for(int row = 0, nRows = table->rowCount(); row < nRows; ++row) {
-			if(table->item(row, 0)->text() == lang.prefix) {
-				lang = {lang.prefix, table->item(row, 1)->text(), QString("%1 [%2]").arg(table->item(row, 2)->text(), lang.prefix)};
-				return true;
-			}
+	for(const Lang& langSpec : langSpecs) {
+		if(langSpec.prefix == lang.prefix) {
+			lang = {lang.prefix, langSpec.code, QString("%1 [%2]").arg(langSpec.name, lang.prefix)};
+			return true;
 		}
 	}
 	return false;
 }
 
-QStringList Config::searchLangCultures(const QString& code) const {
+QString Config::lookupLangCode(const QString& prefix) {
+	int idx = LangTables::findLanguage([&prefix](const char* langPrefix) { return prefix.compare(QLatin1String(langPrefix)); });
+	return idx >= 0 ? QString(LangTables::LANGUAGES[idx].code) : QString();
+}
+
+QStringList Config::searchLangCultures(const QString& code) {
 	return LANGUAGE_CULTURES.values(code);
 }
 
@@ -36,7 +36,10 @@ public:
 	Config(QWidget* parent = nullptr);
 
 	bool searchLangSpec(Lang& lang) const;
-	QStringList searchLangCultures(const QString& code) const;
+	// Copy of the language definitions for use outside the GUI thread
+	QList<Lang> langSpecs() const;
+	static bool searchLangSpec(Lang& lang, const QList<Lang>& langSpecs);
+	static QStringList searchLangCultures(const QString& code);
 	void showDialog();
 
 	bool useUtf8() const;
@@ -46,7 +49,7 @@ public:
 
 	static void openTessdataDir();
 	static void openSpellingDir();
-	static QString lookupLangCode(const QString& prefix) { return LANG_LOOKUP[prefix]; }
+	static QString lookupLangCode(const QString& prefix);
 	static QStringList getAvailableLanguages();
 
 public slots:
@@ -56,7 +59,6 @@ public slots:
 private:
 	enum Location {SystemLocation = 0, UserLocation = 1};
 	static const QList<Lang> LANGUAGES;
-	static const QMap<QString, QString> LANG_LOOKUP;
 	static const QMultiMap<QString, QString> LANGUAGE_CULTURES;
 
 	Ui::ConfigDialog ui;
@@ -17,7 +17,10 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QDataStream>
+#include <QFile>
 #include <QImageReader>
+#include <QSet>
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <poppler-qt6.h>
 #else
@@ -74,22 +77,149 @@ void DisplayRenderer::adjustImage(QImage& image, int brightness, int contrast, b
 	}
 }
 
+/**
+ * Presents a multi-page TIFF as if the directory at a given offset were its first one, by
+ * substituting a patched header. This allows decoding any page without walking the IFD chain.
+ */
+class TiffPageDevice : public QIODevice {
+public:
+	TiffPageDevice(const QString& filename, const QByteArray& header) : m_file(filename), m_header(header) {}
+	bool open(OpenMode mode) override {
+		return m_file.open(mode) && QIODevice::open(mode | QIODevice::Unbuffered);
+	}
+	void close() override {
+		QIODevice::close();
+		m_file.close();
+	}
+	bool isSequential() const override {
+		return false;
+	}
+	qint64 size() const override {
+		return m_file.size();
+	}
+	bool seek(qint64 pos) override {
+		return QIODevice::seek(pos) && m_file.seek(pos);
+	}
+
+protected:
+	qint64 readData(char* data, qint64 maxSize) override {
+		qint64 offset = m_file.pos();
+		qint64 count = m_file.read(data, maxSize);
+		for(qint64 i = offset, n = std::min(offset + count, qint64(m_header.size())); i < n; ++i) {
+			data[i - offset] = m_header[int(i)];
+		}
+		return count;
+	}
+	qint64 writeData(const char* /*data*/, qint64 /*maxSize*/) override {
+		return -1;
+	}
+
+private:
+	QFile m_file;
+	QByteArray m_header;
+};
+
 ImageRenderer::ImageRenderer(const QString& filename) : DisplayRenderer(filename) {
-	m_pageCount = QImageReader(m_filename).imageCount();
+	if(buildTiffIndex(m_filename, m_tiffIndex)) {
+		m_pageCount = m_tiffIndex.ifdOffsets.size();
+	} else {
+		m_tiffIndex = TiffIndex();
+		m_pageCount = QImageReader(m_filename).imageCount();
+	}
 }
 
-QImage ImageRenderer::render(int page, double resolution) const {
-	QImageReader reader(m_filename);
-	reader.jumpToImage(page - 1);
+bool ImageRenderer::buildTiffIndex(const QString& filename, TiffIndex& index) {
+	QFile file(filename);
+	if(!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	QByteArray magic = file.peek(4);
+	if(magic.size() < 4 || (!magic.startsWith("II") && !magic.startsWith("MM"))) {
+		return false;
+	}
+	QDataStream ds(&file);
+	index.bigEndian = magic.startsWith("MM");
+	ds.setByteOrder(index.bigEndian ? QDataStream::BigEndian : QDataStream::LittleEndian);
+	quint16 byteOrder, version;
+	ds >> byteOrder >> version;
+	quint64 offset = 0;
+	if(version == 42) {
+		quint32 offset32;
+		ds >> offset32;
+		offset = offset32;
+	} else if(version == 43) {
+		quint16 offsetSize, reserved;
+		ds >> offsetSize >> reserved >> offset;
+		if(offsetSize != 8) {
+			return false;
+		}
+		index.bigTiff = true;
+	} else {
+		return false;
+	}
+	file.seek(0);
+	index.header = file.read(index.bigTiff ? 16 : 8);
+
+	// Walk the IFD chain once, only reading the entry count and next pointer of each directory
+	QSet<quint64> visited;
+	while(offset != 0 && !visited.contains(offset) && file.seek(offset)) {
+		visited.insert(offset);
+		index.ifdOffsets.append(offset);
+		if(index.bigTiff) {
+			quint64 nEntries;
+			ds >> nEntries;
+			file.seek(offset + 8 + nEntries * 20);
+			ds >> offset;
+		} else {
+			quint16 nEntries;
+			quint32 next;
+			ds >> nEntries;
+			file.seek(offset + 2 + nEntries * 12);
+			ds >> next;
+			offset = next;
+		}
+		if(ds.status() != QDataStream::Ok) {
+			break;
+		}
+	}
+	return !index.ifdOffsets.isEmpty();
+}
+
+void ImageRenderer::setupReader(QImageReader& reader, std::unique_ptr<QIODevice>& device, int page) const {
+	if(page >= 1 && page <= m_tiffIndex.ifdOffsets.size()) {
+		QByteArray header = m_tiffIndex.header;
+		QDataStream ds(&header, QIODevice::ReadWrite);
+		ds.setByteOrder(m_tiffIndex.bigEndian ? QDataStream::BigEndian : QDataStream::LittleEndian);
+		if(m_tiffIndex.bigTiff) {
+			ds.device()->seek(8);
+			ds << quint64(m_tiffIndex.ifdOffsets[page - 1]);
+		} else {
+			ds.device()->seek(4);
+			ds << quint32(m_tiffIndex.ifdOffsets[page - 1]);
+		}
+		device.reset(new TiffPageDevice(m_filename, header));
+		device->open(QIODevice::ReadOnly);
+		reader.setDevice(device.get());
+		reader.setFormat("tiff");
+	} else {
+		reader.setFileName(m_filename);
+		reader.jumpToImage(page - 1);
+	}
 	reader.setBackgroundColor(Qt::white);
+}
+
+QImage ImageRenderer::render(int page, double resolution) const {
+	std::unique_ptr<QIODevice> device;
+	QImageReader reader;
+	setupReader(reader, device, page);
 	reader.setScaledSize(reader.size() * resolution / 100.0);
 	return reader.read().convertToFormat(QImage::Format_RGB32);
 }
 
 QImage ImageRenderer::renderThumbnail(int page) const {
-	QImageReader reader(m_filename);
-	reader.jumpToImage(page - 1);
-	reader.setBackgroundColor(Qt::white);
+	std::unique_ptr<QIODevice> device;
+	QImageReader reader;
+	setupReader(reader, device, page);
 	QSize size = reader.size();
 	double scale = size.width() > size.height() ? (64. / size.width()) : (64. / size.height());
 	reader.setScaledSize(size * scale);
@@ -152,13 +282,16 @@ DJVURenderer::~DJVURenderer() {
 }
 
 QImage DJVURenderer::render(int page, double resolution) const {
-	return m_djvu->image(page, resolution);
+	return m_djvu->image(page - 1, resolution);
 }
 
 QImage DJVURenderer::renderThumbnail(int pageno) const {
-	const DjVuDocument::Page& page = m_djvu->page(pageno);
+	if(pageno < 1 || pageno > m_djvu->pageCount()) {
+		return QImage();
+	}
+	const DjVuDocument::Page& page = m_djvu->page(pageno - 1);
 	double resolution = 64. / qMax(page.width, page.height) * page.dpi;
-	return m_djvu->image(pageno, resolution);
+	return m_djvu->image(pageno - 1, resolution);
 }
 
 int DJVURenderer::getNPages() const {
@@ -23,10 +23,14 @@
 #include <QByteArray>
 #include <QString>
 #include <QMutex>
+#include <QVector>
+#include <memory>
 
 class DjVuDocument;
 
 class QImage;
+class QImageReader;
+class QIODevice;
 namespace Poppler {
 class Document;
 }
@@ -55,6 +59,17 @@ public:
 	}
 private:
 	int m_pageCount;
+
+	// Index of the image file directories of multi-page TIFFs, built once per source
+	struct TiffIndex {
+		QByteArray header;
+		bool bigEndian = false;
+		bool bigTiff = false;
+		QVector<quint64> ifdOffsets;
+	} m_tiffIndex;
+
+	static bool buildTiffIndex(const QString& filename, TiffIndex& index);
+	void setupReader(QImageReader& reader, std::unique_ptr<QIODevice>& device, int page) const;
 };
 
 class PDFRenderer : public DisplayRenderer {
@@ -22,19 +22,24 @@
 #include "Displayer.hh"
 #include "DisplayRenderer.hh"
 #include "SourceManager.hh"
+#include "ThumbnailCache.hh"
 #include "Utils.hh"
 
 #include <cmath>
+#include <cstring>
+#include <functional>
+#include <QAbstractListModel>
+#include <QCache>
 #include <QFileDialog>
 #include <QFuture>
 #include <QGraphicsPixmapItem>
 #include <QGraphicsSceneDragDropEvent>
+#include <QListView>
 #include <QMessageBox>
 #include <QMouseEvent>
 #include <QScrollBar>
 #include <QWheelEvent>
 #include <QtConcurrent/QtConcurrentRun>
-#include <QtConcurrent/QtConcurrentMap>
 
 
 class GraphicsScene : public QGraphicsScene {
@@ -53,6 +58,55 @@ protected:
 	}
 };
 
+class Displayer::ThumbnailModel : public QAbstractListModel {
+public:
+	ThumbnailModel(Displayer* displayer)
+		: QAbstractListModel(displayer), m_displayer(displayer), m_placeholder(":/icons/thumbnail") {
+		m_thumbnails.setMaxCost(500);
+	}
+	void reset(int pageCount) {
+		beginResetModel();
+		m_pageCount = pageCount;
+		m_thumbnails.clear();
+		endResetModel();
+	}
+	bool hasThumbnail(int page) const {
+		return m_thumbnails.contains(page);
+	}
+	void setThumbnail(int page, const QImage& image) {
+		// Pages which failed to render keep the placeholder, rather than being rendered again whenever they are shown
+		m_thumbnails.insert(page, new QIcon(image.isNull() ? m_placeholder : QIcon(QPixmap::fromImage(image))));
+		QModelIndex idx = index(page - 1);
+		emit dataChanged(idx, idx, {Qt::DecorationRole});
+	}
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override {
+		return parent.isValid() ? 0 : m_pageCount;
+	}
+	QVariant data(const QModelIndex& index, int role) const override {
+		if(!index.isValid()) {
+			return QVariant();
+		}
+		if(role == Qt::DisplayRole) {
+			return _("Page %1").arg(index.row() + 1);
+		} else if(role == Qt::DecorationRole) {
+			QIcon* icon = m_thumbnails.object(index.row() + 1);
+			if(icon) {
+				return *icon;
+			}
+			// Views only query the decoration of rows they paint, use this as a hint to update the requests
+			m_displayer->m_thumbnailTimer.start();
+			return m_placeholder;
+		}
+		return QVariant();
+	}
+
+private:
+	Displayer* m_displayer;
+	QIcon m_placeholder;
+	int m_pageCount = 0;
+	QCache<int, QIcon> m_thumbnails;
+};
+
 Displayer::Displayer(const UI_MainWindow& _ui, QWidget* parent)
 	: QGraphicsView(parent), ui(_ui) {
 	m_scene = new GraphicsScene();
@@ -66,6 +120,11 @@ Displayer::Displayer(const UI_MainWindow& _ui, QWidget* parent)
 
 	m_renderTimer.setSingleShot(true);
 	m_scaleTimer.setSingleShot(true);
+	m_thumbnailTimer.setSingleShot(true);
+	m_thumbnailTimer.setInterval(50);
+
+	m_thumbnailModel = new ThumbnailModel(this);
+	ui.listViewThumbnails->setModel(m_thumbnailModel);
 
 	ui.actionRotateLeft->setData(270.0);
 	ui.actionRotateRight->setData(90.0);
@@ -86,17 +145,17 @@ Displayer::Displayer(const UI_MainWindow& _ui, QWidget* parent)
 	connect(&m_renderTimer, &QTimer::timeout, this, &Displayer::renderImage);
 	connect(&m_scaleTimer, &QTimer::timeout, this, &Displayer::scaleImage);
 	connect(&m_scaleWatcher, &QFutureWatcher<QImage>::finished, this, [this] { setScaledImage(m_scaleWatcher.future().result()); });
-	connect(&m_thumbnailWatcher, &QFutureWatcher<QImage>::resultReadyAt, this, &Displayer::setThumbnail);
-	connect(ui.listWidgetThumbnails, &QListWidget::currentRowChanged, [this](int idx) {
-		if(ui.checkBoxThumbnails->isChecked()) {
-			ui.spinBoxPage->setValue(idx + 1);
+	connect(&m_thumbnailTimer, &QTimer::timeout, this, &Displayer::requestThumbnails);
+	connect(this, &Displayer::thumbnailReady, this, &Displayer::setThumbnail, Qt::QueuedConnection);
+	connect(ui.listViewThumbnails->selectionModel(), &QItemSelectionModel::currentRowChanged, [this](const QModelIndex & idx) {
+		if(ui.checkBoxThumbnails->isChecked() && idx.isValid()) {
+			ui.spinBoxPage->setValue(idx.row() + 1);
 		}
 	});
+	connect(ui.listViewThumbnails->verticalScrollBar(), &QScrollBar::valueChanged, &m_thumbnailTimer, qOverload<>(&QTimer::start));
+	connect(ui.listViewThumbnails->verticalScrollBar(), &QScrollBar::rangeChanged, &m_thumbnailTimer, qOverload<>(&QTimer::start));
 	connect(ui.checkBoxThumbnails, &QCheckBox::toggled, this, &Displayer::thumbnailsToggled);
-	connect(ui.spinBoxPage, qOverload<int>(&QSpinBox::valueChanged), this, [this](int page) {
-		QSignalBlocker blocker(ui.listWidgetThumbnails);
-		ui.listWidgetThumbnails->setCurrentRow(page - 1);
-	});
+	connect(ui.spinBoxPage, qOverload<int>(&QSpinBox::valueChanged), this, &Displayer::setCurrentThumbnail);
 	connect(horizontalScrollBar(), &QScrollBar::valueChanged, this, &Displayer::checkViewportChanged);
 	connect(horizontalScrollBar(), &QScrollBar::rangeChanged, this, &Displayer::checkViewportChanged);
 	connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &Displayer::checkViewportChanged);
@@ -106,6 +165,7 @@ Displayer::Displayer(const UI_MainWindow& _ui, QWidget* parent)
 }
 
 Displayer::~Displayer() {
+	m_thumbnailTimer.stop();
 	setSources(QList<Source*>());
 	delete m_scene;
 }
@@ -117,9 +177,7 @@ bool Displayer::setSources(QList<Source*> sources) {
 
 	m_scaleTimer.stop();
 	m_scaleWatcher.waitForFinished();
-	m_thumbnailWatcher.cancel();
-	m_thumbnailWatcher.waitForFinished();
-	ui.listWidgetThumbnails->clear();
+	cancelThumbnails();
 	if(m_tool) {
 		m_tool->reset();
 	}
@@ -133,6 +191,7 @@ bool Displayer::setSources(QList<Source*> sources) {
 	m_sources.clear();
 	m_pageMap.clear();
 	m_pixmap = QPixmap();
+	m_image = QImage();
 	m_imageItem = nullptr;
 	ui.actionBestFit->setChecked(true);
 	ui.actionPage->setVisible(false);
@@ -209,8 +268,7 @@ bool Displayer::setup(const int* page, const int* resolution, const double* angl
 	if(page) {
 		changed |= *page != ui.spinBoxPage->value();
 		Utils::setSpinBlocked(ui.spinBoxPage, *page);
-		QSignalBlocker blocker(ui.listWidgetThumbnails);
-		ui.listWidgetThumbnails->setCurrentRow(*page - 1);
+		setCurrentThumbnail(*page);
 	}
 	if(resolution) {
 		changed |= *resolution != ui.spinBoxResolution->value();
@@ -288,7 +346,8 @@ bool Displayer::renderImage() {
 		return false;
 	}
 	renderer->adjustImage(image, m_currentSource->brightness, m_currentSource->contrast, m_currentSource->invert);
-	m_pixmap = QPixmap::fromImage(image);
+	m_image = image.convertToFormat(QImage::Format_RGB32);
+	m_pixmap = QPixmap::fromImage(m_image);
 	m_imageItem->setPixmap(m_pixmap);
 	m_imageItem->setScale(1.);
 	m_imageItem->setTransformOriginPoint(m_imageItem->boundingRect().center());
@@ -519,19 +578,90 @@ void Displayer::setRotateMode(QAction* action) {
 }
 
 QImage Displayer::getImage(const QRectF& rect) {
-	QImage image(rect.width(), rect.height(), QImage::Format_RGB32);
-	image.fill(Qt::black);
-	QPainter painter(&image);
-	painter.setRenderHint(QPainter::SmoothPixmapTransform);
+	int width = rect.width();
+	int height = rect.height();
+	if(m_image.isNull() || width <= 0 || height <= 0) {
+		return QImage();
+	}
+	double angle = ui.spinBoxRotation->value();
 	QTransform t;
-	t.translate(-rect.x(), -rect.y());
-	t.rotate(ui.spinBoxRotation->value());
-	t.translate(-0.5 * m_pixmap.width(), -0.5 * m_pixmap.height());
-	painter.setTransform(t);
-	painter.drawPixmap(0, 0, m_pixmap);
+	t.rotate(angle);
+	t.translate(-0.5 * m_image.width(), -0.5 * m_image.height());
+	QTransform inv = t.inverted();
+
+	// Fast path: for multiples of 90 degrees, extract the area from the retained image and rotate it losslessly
+	double quadrants = angle / 90.;
+	if(std::abs(quadrants - std::round(quadrants)) < 1e-6) {
+		QRectF srcRectF = inv.mapRect(QRectF(rect.x(), rect.y(), width, height));
+		QRect srcRect(qRound(srcRectF.x()), qRound(srcRectF.y()), qRound(srcRectF.width()), qRound(srcRectF.height()));
+		QImage crop = cropImage(m_image, srcRect);
+		int rotation = (int(std::round(quadrants)) % 4 + 4) % 4;
+		return rotation == 0 ? crop : crop.transformed(QTransform().rotate(90 * rotation));
+	}
+
+	// Arbitrary angle: sample the retained image through the inverse transform
+	QImage image(width, height, QImage::Format_RGB32);
+	const uchar* srcBits = m_image.constBits();
+	int srcBpl = m_image.bytesPerLine();
+	int srcWidth = m_image.width();
+	int srcHeight = m_image.height();
+	// Pixel values are sampled at pixel centers, in 16.16 fixed point
+	QPointF origin = inv.map(QPointF(rect.x() + 0.5, rect.y() + 0.5)) - QPointF(0.5, 0.5);
+	QPointF dx = inv.map(QPointF(1, 0)) - inv.map(QPointF(0, 0));
+	QPointF dy = inv.map(QPointF(0, 1)) - inv.map(QPointF(0, 0));
+	auto sample = [&](int x, int y) {
+		return x >= 0 && y >= 0 && x < srcWidth && y < srcHeight ? reinterpret_cast<const QRgb*>(srcBits + y * srcBpl)[x] : qRgb(0, 0, 0);
+	};
+	#pragma omp parallel for
+	for(int line = 0; line < height; ++line) {
+		QRgb* dst = reinterpret_cast<QRgb*>(image.scanLine(line));
+		qint64 fx = qint64((origin.x() + line * dy.x()) * 65536.);
+		qint64 fy = qint64((origin.y() + line * dy.y()) * 65536.);
+		qint64 stepX = qint64(dx.x() * 65536.);
+		qint64 stepY = qint64(dx.y() * 65536.);
+		for(int i = 0; i < width; ++i, fx += stepX, fy += stepY) {
+			int x0 = int(fx >> 16);
+			int y0 = int(fy >> 16);
+			if(x0 < -1 || y0 < -1 || x0 >= srcWidth || y0 >= srcHeight) {
+				dst[i] = qRgb(0, 0, 0);
+				continue;
+			}
+			uint wx = (fx >> 8) & 0xFF;
+			uint wy = (fy >> 8) & 0xFF;
+			QRgb p00 = sample(x0, y0);
+			QRgb p10 = sample(x0 + 1, y0);
+			QRgb p01 = sample(x0, y0 + 1);
+			QRgb p11 = sample(x0 + 1, y0 + 1);
+			auto interpolate = [&](int shift) {
+				uint top = ((p00 >> shift) & 0xFF) * (256 - wx) + ((p10 >> shift) & 0xFF) * wx;
+				uint bottom = ((p01 >> shift) & 0xFF) * (256 - wx) + ((p11 >> shift) & 0xFF) * wx;
+				return (top * (256 - wy) + bottom * wy) >> 16;
+			};
+			dst[i] = qRgb(interpolate(16), interpolate(8), interpolate(0));
+		}
+	}
 	return image;
 }
 
+QImage Displayer::cropImage(const QImage& image, const QRect& rect) {
+	if(image.rect().contains(rect)) {
+		return image.copy(rect);
+	}
+	// Areas outside the image are black
+	QImage crop(rect.size(), QImage::Format_RGB32);
+	crop.fill(Qt::black);
+	QRect overlap = rect.intersected(image.rect());
+	if(!overlap.isEmpty()) {
+		int bytes = overlap.width() * 4;
+		for(int y = overlap.top(); y <= overlap.bottom(); ++y) {
+			const uchar* src = image.constScanLine(y) + overlap.left() * 4;
+			uchar* dst = crop.scanLine(y - rect.top()) + (overlap.left() - rect.left()) * 4;
+			std::memcpy(dst, src, bytes);
+		}
+	}
+	return crop;
+}
+
 QRectF Displayer::getSceneBoundingRect() const {
 	// We cannot use m_imageItem->sceneBoundingRect() since its pixmap
 	// can currently be downscaled and therefore have slightly different
@@ -581,45 +711,126 @@ void Displayer::setScaledImage(QImage image) {
 }
 
 void Displayer::thumbnailsToggled(bool active) {
-	ui.listWidgetThumbnails->setVisible(active);
+	ui.listViewThumbnails->setVisible(active);
 	ui.splitter->setSizes(active ? QList<int>() << 50 << 50 : QList<int>() << ui.tabSources->height() << 1);
 	if(active) {
 		if (!m_pageMap.isEmpty()) {
 			generateThumbnails();
-			QSignalBlocker blocker(ui.listWidgetThumbnails);
-			ui.listWidgetThumbnails->setCurrentRow(ui.spinBoxPage->value() - 1);
+			setCurrentThumbnail(ui.spinBoxPage->value());
 		}
 	} else {
-		m_thumbnailWatcher.cancel();
-		m_thumbnailWatcher.waitForFinished();
-		ui.listWidgetThumbnails->clear();
+		cancelThumbnails();
 	}
 }
 
 void Displayer::generateThumbnails() {
 	if(ui.checkBoxThumbnails->isChecked()) {
-		QList<int> pages = m_pageMap.keys();
-		ui.listWidgetThumbnails->setUpdatesEnabled(false);
-		QIcon icon(":/icons/thumbnail");
-		for(int page : pages) {
-			QListWidgetItem* item = new QListWidgetItem(icon, _("Page %1").arg(page));
-			ui.listWidgetThumbnails->addItem(item);
+		m_thumbnailModel->reset(m_pageMap.size());
+		m_thumbnailTimer.start();
+	}
+}
+
+void Displayer::cancelThumbnails() {
+	m_thumbnailTimer.stop();
+	m_thumbnailMutex.lock();
+	m_thumbnailRequests.clear();
+	m_thumbnailMutex.unlock();
+	m_thumbnailPool.clear();
+	m_thumbnailPool.waitForDone();
+	m_thumbnailsQueued.clear();
+	++m_thumbnailGeneration;
+	m_thumbnailModel->reset(0);
+}
+
+void Displayer::setCurrentThumbnail(int page) {
+	QItemSelectionModel* selectionModel = ui.listViewThumbnails->selectionModel();
+	QSignalBlocker blocker(selectionModel);
+	QModelIndex index = m_thumbnailModel->index(page - 1);
+	selectionModel->setCurrentIndex(index, QItemSelectionModel::ClearAndSelect);
+	ui.listViewThumbnails->scrollTo(index);
+}
+
+void Displayer::requestThumbnails() {
+	int nPages = m_thumbnailModel->rowCount();
+	if(nPages == 0 || !ui.listViewThumbnails->isVisible()) {
+		return;
+	}
+	// Rows are laid out in increasing y order, so the visible range can be found by bisection
+	QListView* view = ui.listViewThumbnails;
+	int height = view->viewport()->height();
+	auto lowerBound = [&](const std::function<bool(const QRect&)>& before) {
+		int lo = 0, hi = nPages;
+		while(lo < hi) {
+			int mid = (lo + hi) / 2;
+			if(before(view->visualRect(m_thumbnailModel->index(mid)))) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		return lo;
+	};
+	int first = lowerBound([](const QRect & r) { return r.bottom() < 0; });
+	int last = lowerBound([height](const QRect & r) { return r.top() <= height; }) - 1;
+	// Prefetch one screen above and below the visible rows
+	int margin = std::max(0, last - first + 1);
+	first = std::max(0, first - margin);
+	last = std::min(nPages - 1, last + margin);
+
+	QSet<int> requests;
+	for(int row = first; row <= last; ++row) {
+		if(!m_thumbnailModel->hasThumbnail(row + 1)) {
+			requests.insert(row + 1);
+		}
+	}
+	// Replacing the request set cancels pending renders of rows which were scrolled away
+	m_thumbnailMutex.lock();
+	m_thumbnailRequests = requests;
+	m_thumbnailMutex.unlock();
+
+	int generation = m_thumbnailGeneration;
+	for(int page : requests) {
+		if(m_thumbnailsQueued.contains(page)) {
+			continue;
 		}
-		ui.listWidgetThumbnails->setUpdatesEnabled(true);
-		m_thumbnailWatcher.setFuture(QtConcurrent::mapped(pages, static_cast<std::function<QImage(int)>>([this](int page) { return renderThumbnail(page); })));
+		m_thumbnailsQueued.insert(page);
+		QtConcurrent::run(&m_thumbnailPool, [this, generation, page] {
+			m_thumbnailMutex.lock();
+			bool wanted = m_thumbnailRequests.contains(page);
+			m_thumbnailMutex.unlock();
+			emit thumbnailReady(generation, page, wanted ? renderThumbnail(page) : QImage(), wanted);
+		});
 	}
 }
 
 QImage Displayer::renderThumbnail(int page) {
-	QPair<Source*, int> map = m_pageMap[page];
-	DisplayRenderer* renderer = m_sourceRenderers[map.first];
-	return renderer ? renderer->renderThumbnail(map.second) : QImage();
+	QPair<Source*, int> map = m_pageMap.value(page);
+	DisplayRenderer* renderer = m_sourceRenderers.value(map.first);
+	if(!renderer) {
+		return QImage();
+	}
+	// Thumbnails of password protected documents are never written to disk
+	bool cached = map.first->password.isEmpty();
+	QImage image = cached ? ThumbnailCache::load(map.first->path, map.second) : QImage();
+	if(image.isNull()) {
+		image = renderer->renderThumbnail(map.second);
+		if(cached && !map.first->isTemp) {
+			ThumbnailCache::store(map.first->path, map.second, image);
+		}
+	}
+	return image;
 }
 
-void Displayer::setThumbnail(int index) {
-	QImage image = m_thumbnailWatcher.resultAt(index);
-	if(!image.isNull()) {
-		ui.listWidgetThumbnails->item(index)->setIcon(QPixmap::fromImage(image));
+void Displayer::setThumbnail(int generation, int page, const QImage& image, bool rendered) {
+	if(generation != m_thumbnailGeneration) {
+		return;
+	}
+	m_thumbnailsQueued.remove(page);
+	if(rendered) {
+		m_thumbnailModel->setThumbnail(page, image);
+	} else {
+		// Render was skipped, but the row may have become visible again in the meantime
+		m_thumbnailTimer.start();
 	}
 }
 
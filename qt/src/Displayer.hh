@@ -25,6 +25,9 @@
 #include <QGraphicsView>
 #include <QImage>
 #include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
 #include <QTimer>
 
 class DisplayerTool;
@@ -70,12 +73,15 @@ public:
 signals:
 	void viewportChanged();
 	void imageChanged();
+	void thumbnailReady(int generation, int page, QImage image, bool rendered);
 
 
 public slots:
 	void autodetectOCRAreas();
 
 private:
+	class ThumbnailModel;
+
 	enum class RotateMode { CurrentPage, AllPages } m_rotateMode;
 	enum class Zoom { In, Out, Fit, Original };
 	const UI_MainWindow& ui;
@@ -85,6 +91,7 @@ private:
 	QMap<int, QPair<Source*, int>> m_pageMap;
 	Source* m_currentSource = nullptr;
 	QPixmap m_pixmap;
+	QImage m_image; // Full resolution RGB32 copy of m_pixmap, from which OCR areas are extracted
 	QGraphicsPixmapItem* m_imageItem = nullptr;
 	double m_scale = 1.0;
 	DisplayerTool* m_tool = nullptr;
@@ -100,13 +107,23 @@ private:
 	void wheelEvent(QWheelEvent* event) override;
 
 	void setZoom(Zoom action, QGraphicsView::ViewportAnchor anchor = QGraphicsView::AnchorViewCenter);
+	static QImage cropImage(const QImage& image, const QRect& rect);
 	void generateThumbnails();
+	void cancelThumbnails();
 	void thumbnailsToggled(bool active);
+	void setCurrentThumbnail(int page);
 
 	QTimer m_scaleTimer;
 	QFutureWatcher<QImage> m_scaleWatcher;
 
-	QFutureWatcher<QImage> m_thumbnailWatcher;
+	// Thumbnails are only rendered for pages in or near the visible part of the thumbnail list
+	ThumbnailModel* m_thumbnailModel;
+	QTimer m_thumbnailTimer;
+	QThreadPool m_thumbnailPool;
+	QMutex m_thumbnailMutex;
+	QSet<int> m_thumbnailRequests; // Pages still wanted, guarded by m_thumbnailMutex
+	QSet<int> m_thumbnailsQueued; // Pages with a pending render task
+	int m_thumbnailGeneration = 0;
 
 private slots:
 	void checkViewportChanged();
@@ -130,7 +147,8 @@ private slots:
 		setZoom(Zoom::Original);
 	}
 	QImage renderThumbnail(int page);
-	void setThumbnail(int index);
+	void requestThumbnails();
+	void setThumbnail(int generation, int page, const QImage& image, bool rendered);
 };
 
 
@@ -13,6 +13,7 @@
 #include "DjVuDocument.hh"
 
 #include <QFile>
+#include <QMutexLocker>
 #include <QPainter>
 
 #include <libdjvu/ddjvuapi.h>
@@ -98,6 +99,9 @@ bool DjVuDocument::openFile( const QString& fileName ) {
 }
 
 void DjVuDocument::closeFile() {
+	m_cacheMutex.lock();
+	m_pageCache.clear();
+	m_cacheMutex.unlock();
 	m_pages.clear();
 	// releasing the old document
 	if ( m_djvu_document ) {
@@ -106,6 +110,41 @@ void DjVuDocument::closeFile() {
 	m_djvu_document = nullptr;
 }
 
+DjVuDocument::PagePtr DjVuDocument::decodedPage( int pageno ) {
+	PagePtr djvupage;
+	m_cacheMutex.lock();
+	for ( int i = 0, n = m_pageCache.size(); i < n; ++i ) {
+		if ( m_pageCache[i].first == pageno ) {
+			djvupage = m_pageCache[i].second;
+			m_pageCache.move( i, 0 );
+			break;
+		}
+	}
+	if ( !djvupage ) {
+		ddjvu_page_t* p = ddjvu_page_create_by_pageno( m_djvu_document, pageno );
+		if ( p ) {
+			// Pages still in use by a renderer stay alive after eviction until the last reference is dropped
+			djvupage = PagePtr( p, ddjvu_page_release );
+			m_pageCache.prepend( qMakePair( pageno, djvupage ) );
+			while ( m_pageCache.size() > sPageCacheSize ) {
+				m_pageCache.removeLast();
+			}
+		}
+	}
+	m_cacheMutex.unlock();
+	if ( !djvupage ) {
+		return djvupage;
+	}
+
+	// wait for the page to be decoded. Only one thread may drain the message queue at any time,
+	// otherwise a thread could block forever waiting for a message already consumed by another one.
+	QMutexLocker locker( &m_messageMutex );
+	while ( ddjvu_page_decoding_status( djvupage.get() ) < DDJVU_JOB_OK ) {
+		handle_ddjvu_messages( m_djvu_cxt, true );
+	}
+	return djvupage;
+}
+
 QImage DjVuDocument::image( int pageno, int resolution ) {
 	if(pageno < 0 || pageno >= pageCount()) {
 		return QImage();
@@ -113,12 +152,7 @@ QImage DjVuDocument::image( int pageno, int resolution ) {
 
 	const DjVuDocument::Page& page = m_pages[pageno];
 
-	ddjvu_page_t* djvupage = ddjvu_page_create_by_pageno( m_djvu_document, pageno );
-	// wait for the new page to be loaded
-	ddjvu_status_t sts;
-	while ( ( sts = ddjvu_page_decoding_status( djvupage ) ) < DDJVU_JOB_OK ) {
-		handle_ddjvu_messages( m_djvu_cxt, true );
-	}
+	PagePtr djvupage = decodedPage( pageno );
 
 	double scaleFactor = double(resolution) / double(page.dpi);
 	ddjvu_rect_t pagerect;
@@ -128,11 +162,11 @@ QImage DjVuDocument::image( int pageno, int resolution ) {
 	pagerect.h = page.height * scaleFactor;
 	ddjvu_rect_t renderrect = pagerect;
 	QImage res_img( renderrect.w, renderrect.h, QImage::Format_RGB32 );
-	int res = ddjvu_page_render( djvupage, DDJVU_RENDER_COLOR, &pagerect, &renderrect, m_format, res_img.bytesPerLine(), (char*)res_img.bits() );
+	int res = djvupage && ddjvu_page_decoding_status( djvupage.get() ) == DDJVU_JOB_OK &&
+	          ddjvu_page_render( djvupage.get(), DDJVU_RENDER_COLOR, &pagerect, &renderrect, m_format, res_img.bytesPerLine(), (char*)res_img.bits() );
 	if (!res) {
 		res_img.fill(Qt::white);
 	}
 
-	ddjvu_page_release(djvupage);
 	return res_img;
 }
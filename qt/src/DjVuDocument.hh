@@ -14,11 +14,16 @@
 #define DJVUDOCUMENT_HH
 
 #include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPair>
 #include <QVector>
+#include <memory>
 
 typedef struct ddjvu_context_s    ddjvu_context_t;
 typedef struct ddjvu_document_s   ddjvu_document_t;
 typedef struct ddjvu_format_s     ddjvu_format_t;
+typedef struct ddjvu_page_s       ddjvu_page_t;
 
 class DjVuDocument {
 public:
@@ -33,6 +38,7 @@ public:
 
 	bool openFile( const QString& fileName );
 	void closeFile();
+	// Thread-safe
 	QImage image(int pageno, int resolution);
 	int pageCount() const {
 		return m_pages.size();
@@ -40,11 +46,22 @@ public:
 	const Page& page(int pageno) const { return m_pages[pageno]; }
 
 private:
+	typedef std::shared_ptr<ddjvu_page_t> PagePtr;
+
+	static constexpr int sPageCacheSize = 8;
 
 	ddjvu_context_t* m_djvu_cxt = nullptr;
 	ddjvu_document_t* m_djvu_document = nullptr;
 	ddjvu_format_t* m_format = nullptr;
 	QVector<Page> m_pages;
+
+	// Decoded pages, most recently used first
+	QList<QPair<int, PagePtr>> m_pageCache;
+	QMutex m_cacheMutex;
+	// Serializes access to the message queue of the djvu context
+	QMutex m_messageMutex;
+
+	PagePtr decodedPage(int pageno);
 };
 
 #endif
@@ -0,0 +1,421 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * EditJournal.cc
+ * Copyright (C) 2022 Sandro Mani <manisandro@gmail.com>
+ *
+ * gImageReader is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gImageReader is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtEndian>
+#include <algorithm>
+#include <memory>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "EditJournal.hh"
+
+static const char* sJournalMagic = "gIRJ";
+static const char* sSnapshotMagic = "gIRS";
+static constexpr quint32 sFormatVersion = 1;
+static constexpr int sHeaderSize = 12;
+static constexpr int sFlushInterval = 2000;
+// Journals are compacted once they are larger than their snapshot, but not below this size
+static constexpr qint64 sMinCompactSize = 4 * 1024 * 1024;
+
+static quint16 checksum(const char* data, int len) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+	return qChecksum(QByteArrayView(data, len));
+#else
+	return qChecksum(data, len);
+#endif
+}
+
+static void appendHeader(QByteArray& out, const char* magic, int generation) {
+	char buf[8];
+	qToBigEndian<quint32>(sFormatVersion, buf);
+	qToBigEndian<quint32>(generation, buf + 4);
+	out.append(magic, 4);
+	out.append(buf, 8);
+}
+
+static bool checkHeader(const QByteArray& data, const char* magic, int generation) {
+	return data.size() >= sHeaderSize && data.startsWith(magic) &&
+	       qFromBigEndian<quint32>(data.constData() + 4) == sFormatVersion &&
+	       qFromBigEndian<quint32>(data.constData() + 8) == quint32(generation);
+}
+
+EditJournal::EditJournal(const QString& name, QObject* parent)
+	: QObject(parent), m_name(name) {
+	m_flushTimer.setSingleShot(true);
+	m_flushTimer.setInterval(sFlushInterval);
+	connect(&m_flushTimer, &QTimer::timeout, this, &EditJournal::flush);
+	connect(&m_compactWatcher, &QFutureWatcher<qint64>::finished, this, &EditJournal::compactionFinished);
+}
+
+EditJournal::~EditJournal() {
+	discard();
+}
+
+bool EditJournal::reset(const QByteArray& snapshot) {
+	discard();
+	int generation = m_generation + 1;
+	m_haveFiles = true;
+	if(!QDir().mkpath(sessionDir()) || !writeSnapshot(filePath(generation, "snapshot"), generation, snapshot) || !openJournal(generation)) {
+		qWarning("Failed to create edit journal in %s", qPrintable(sessionDir()));
+		removeFiles(generation + 1);
+		return false;
+	}
+	m_generation = generation;
+	m_snapshotSize = snapshot.size();
+	return true;
+}
+
+void EditJournal::append(quint8 type, const QByteArray& data) {
+	// Records before the first snapshot are contained in it
+	if(!isActive()) {
+		return;
+	}
+	appendRecord(m_buffer, type, data);
+}
+
+void EditJournal::scheduleFlush() {
+	// Not restarted on further edits, so that continuous editing is still flushed regularly
+	if(!m_flushTimer.isActive()) {
+		m_flushTimer.start();
+	}
+}
+
+void EditJournal::flush() {
+	m_flushTimer.stop();
+	emit aboutToFlush();
+	if(!isActive() || m_buffer.isEmpty() || !writeBuffer()) {
+		return;
+	}
+	int handle = m_file.handle();
+	m_sync = QtConcurrent::run([handle] { syncHandle(handle); });
+	if(!m_compactionRequested && !m_compactWatcher.isRunning() && m_size > std::max(sMinCompactSize, m_snapshotSize)) {
+		m_compactionRequested = true;
+		emit compactionRequested();
+	}
+}
+
+void EditJournal::compact(const QByteArray& snapshot) {
+	startCompaction(snapshot, nullptr);
+}
+
+void EditJournal::compact(const Compactor& compactor) {
+	startCompaction(QByteArray(), compactor);
+}
+
+void EditJournal::startCompaction(const QByteArray& snapshot, const Compactor& compactor) {
+	// A running compaction is not waited for, the next flush requests a compaction again if it is still necessary
+	m_compactionRequested = false;
+	if(!isActive() || m_compactWatcher.isRunning()) {
+		return;
+	}
+	// Pending records belong to the current generation, which remains valid until the new snapshot is complete
+	if(!writeBuffer()) {
+		return;
+	}
+	closeJournal();
+	int generation = m_generation + 1;
+	if(!openJournal(generation)) {
+		qWarning("Failed to create edit journal in %s", qPrintable(sessionDir()));
+		return;
+	}
+	m_generation = generation;
+	m_compactGeneration = generation;
+	QString session = sessionDir();
+	QString name = m_name;
+	QString path = filePath(generation, "snapshot");
+	m_compactWatcher.setFuture(QtConcurrent::run([session, name, path, generation, snapshot, compactor] {
+		QByteArray data = snapshot;
+		if(compactor) {
+			// The files of the previous generations are no longer written to
+			QByteArray previous;
+			QVector<Record> records;
+			if(!read(session, name, previous, records, generation)) {
+				return qint64(-1);
+			}
+			data = compactor(previous, records);
+		}
+		return writeSnapshot(path, generation, data) ? qint64(data.size()) : qint64(-1);
+	}));
+}
+
+void EditJournal::discard() {
+	m_flushTimer.stop();
+	m_buffer.clear();
+	if(!m_haveFiles) {
+		return;
+	}
+	// A running compaction is not waited for, its snapshot is removed once it is written
+	m_sync.waitForFinished();
+	m_file.close();
+	removeFiles(m_generation + 1);
+	m_haveFiles = false;
+	m_size = 0;
+	m_snapshotSize = 0;
+	m_compactionRequested = false;
+}
+
+QString EditJournal::filePath(int generation, const QString& suffix) const {
+	return QDir(sessionDir()).absoluteFilePath(QString("%1-%2.%3").arg(m_name).arg(generation).arg(suffix));
+}
+
+bool EditJournal::openJournal(int generation) {
+	m_file.setFileName(filePath(generation, "journal"));
+	if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+	QByteArray header;
+	appendHeader(header, sJournalMagic, generation);
+	if(m_file.write(header) != header.size() || !m_file.flush()) {
+		m_file.close();
+		m_file.remove();
+		return false;
+	}
+	m_size = 0;
+	return true;
+}
+
+void EditJournal::closeJournal() {
+	if(isActive()) {
+		m_sync.waitForFinished();
+		writeBuffer();
+		if(isActive()) {
+			syncHandle(m_file.handle());
+			m_file.close();
+		}
+	}
+	m_buffer.clear();
+}
+
+bool EditJournal::writeBuffer() {
+	if(m_buffer.isEmpty()) {
+		return true;
+	}
+	m_sync.waitForFinished();
+	if(m_file.write(m_buffer) != m_buffer.size() || !m_file.flush()) {
+		// Stop journaling rather than writing records after a gap
+		qWarning("Failed to write edit journal %s", qPrintable(m_file.fileName()));
+		m_file.close();
+		m_buffer.clear();
+		return false;
+	}
+	m_size += m_buffer.size();
+	m_buffer.clear();
+	return true;
+}
+
+void EditJournal::removeFiles(int belowGeneration) {
+	QString session = sessionDir(false);
+	QDir dir(session);
+	for(const QString& suffix : {QString("snapshot"), QString("journal")}) {
+		QMap<int, QString> files = generationFiles(session, m_name, suffix);
+		for(auto it = files.begin(), itEnd = files.lowerBound(belowGeneration); it != itEnd; ++it) {
+			dir.remove(it.value());
+		}
+	}
+}
+
+void EditJournal::compactionFinished() {
+	qint64 size = m_compactWatcher.future().result();
+	if(m_compactGeneration != m_generation || !isActive()) {
+		// The journal was discarded while the snapshot was written
+		QFile::remove(filePath(m_compactGeneration, "snapshot"));
+	} else if(size >= 0) {
+		m_snapshotSize = size;
+		removeFiles(m_compactGeneration);
+	}
+}
+
+QString EditJournal::rootDir() {
+	return QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).absoluteFilePath("journal");
+}
+
+QString EditJournal::sessionDir(bool create) {
+	// Locked until the process exits, locks of crashed processes are detected as stale
+	static QString dir;
+	static std::unique_ptr<QLockFile> lock;
+	if(dir.isEmpty() && create) {
+		dir = QDir(rootDir()).absoluteFilePath(QString("%1-%2").arg(QDateTime::currentMSecsSinceEpoch()).arg(QCoreApplication::applicationPid()));
+		QDir().mkpath(dir);
+		lock.reset(new QLockFile(QDir(dir).absoluteFilePath("lock")));
+		lock->tryLock(0);
+	}
+	return dir;
+}
+
+QMap<int, QString> EditJournal::generationFiles(const QString& session, const QString& name, const QString& suffix) {
+	QMap<int, QString> files;
+	if(session.isEmpty()) {
+		return files;
+	}
+	int prefixLength = name.length() + 1;
+	for(const QString& entry : QDir(session).entryList({QString("%1-*.%2").arg(name).arg(suffix)}, QDir::Files)) {
+		bool ok = false;
+		int generation = entry.mid(prefixLength, entry.length() - prefixLength - suffix.length() - 1).toInt(&ok);
+		if(ok) {
+			files.insert(generation, entry);
+		}
+	}
+	return files;
+}
+
+bool EditJournal::writeSnapshot(const QString& path, int generation, const QByteArray& snapshot) {
+	// The save file is synced before being renamed, so an existing snapshot is always complete
+	QSaveFile file(path);
+	if(!file.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+	QByteArray header;
+	appendHeader(header, sSnapshotMagic, generation);
+	char buf[2];
+	qToBigEndian<quint16>(checksum(snapshot.constData(), snapshot.size()), buf);
+	if(file.write(header) != header.size() || file.write(snapshot) != snapshot.size() || file.write(buf, 2) != 2) {
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
+
+bool EditJournal::readSnapshot(const QString& path, int generation, QByteArray& snapshot) {
+	QFile file(path);
+	if(!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	QByteArray data = file.readAll();
+	if(!checkHeader(data, sSnapshotMagic, generation) || data.size() < sHeaderSize + 2) {
+		return false;
+	}
+	int size = data.size() - sHeaderSize - 2;
+	if(checksum(data.constData() + sHeaderSize, size) != qFromBigEndian<quint16>(data.constData() + sHeaderSize + size)) {
+		return false;
+	}
+	snapshot = data.mid(sHeaderSize, size);
+	return true;
+}
+
+bool EditJournal::readJournal(const QString& path, int generation, QVector<Record>& records) {
+	QFile file(path);
+	if(!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	QByteArray data = file.readAll();
+	if(!checkHeader(data, sJournalMagic, generation)) {
+		return false;
+	}
+	return readRecords(data, sHeaderSize, records);
+}
+
+void EditJournal::appendRecord(QByteArray& out, quint8 type, const QByteArray& data) {
+	// Record: size, type, data, checksum of type and data
+	char buf[4];
+	qToBigEndian<quint32>(data.size(), buf);
+	out.append(buf, 4);
+	int start = out.size();
+	out.append(char(type));
+	out.append(data);
+	qToBigEndian<quint16>(checksum(out.constData() + start, out.size() - start), buf);
+	out.append(buf, 2);
+}
+
+bool EditJournal::readRecords(const QByteArray& data, int pos, QVector<Record>& records) {
+	// A crash can leave a torn record at the end, everything from the first damaged record on is dropped
+	while(data.size() - pos >= 7) {
+		quint32 size = qFromBigEndian<quint32>(data.constData() + pos);
+		if(size > quint32(data.size() - pos - 7)) {
+			return false;
+		}
+		const char* record = data.constData() + pos + 4;
+		if(checksum(record, size + 1) != qFromBigEndian<quint16>(record + size + 1)) {
+			return false;
+		}
+		records.append(Record{quint8(record[0]), QByteArray(record + 1, size)});
+		pos += size + 7;
+	}
+	return pos == data.size();
+}
+
+QStringList EditJournal::crashedSessions() {
+	QStringList sessions;
+	QDir root(rootDir());
+	for(const QString& entry : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+		QString session = root.absoluteFilePath(entry);
+		if(session == sessionDir(false)) {
+			continue;
+		}
+		// Sessions of running instances are locked
+		QLockFile lock(QDir(session).absoluteFilePath("lock"));
+		lock.setStaleLockTime(0);
+		if(!lock.tryLock(0)) {
+			continue;
+		}
+		lock.unlock();
+		// Journals only exist while there are unsaved edits
+		if(!QDir(session).entryList({"*.journal"}, QDir::Files).isEmpty()) {
+			sessions.append(session);
+		} else {
+			removeSession(session);
+		}
+	}
+	return sessions;
+}
+
+bool EditJournal::hasJournal(const QString& session, const QString& name) {
+	return !generationFiles(session, name, "journal").isEmpty();
+}
+
+bool EditJournal::read(const QString& session, const QString& name, QByteArray& snapshot, QVector<Record>& records, int maxGeneration) {
+	// Journals of generations older than the most recent complete snapshot are contained in it
+	QMap<int, QString> snapshots = generationFiles(session, name, "snapshot");
+	QMap<int, QString> journals = generationFiles(session, name, "journal");
+	QDir dir(session);
+	for(auto it = snapshots.lowerBound(maxGeneration), itBegin = snapshots.begin(); it != itBegin;) {
+		--it;
+		if(!readSnapshot(dir.absoluteFilePath(it.value()), it.key(), snapshot)) {
+			continue;
+		}
+		for(auto jt = journals.lowerBound(it.key()), jtEnd = journals.lowerBound(maxGeneration); jt != jtEnd; ++jt) {
+			if(!readJournal(dir.absoluteFilePath(jt.value()), jt.key(), records)) {
+				break;
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+void EditJournal::removeSession(const QString& session) {
+	QDir(session).removeRecursively();
+}
+
+void EditJournal::syncHandle(int handle) {
+#ifdef Q_OS_WIN
+	_commit(handle);
+#else
+	::fsync(handle);
+#endif
+}
@@ -0,0 +1,112 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * EditJournal.hh
+ * Copyright (C) 2022 Sandro Mani <manisandro@gmail.com>
+ *
+ * gImageReader is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gImageReader is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EDITJOURNAL_HH
+#define EDITJOURNAL_HH
+
+#include <QFile>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QMap>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+#include <limits>
+
+/**
+ * Append-only journal of output editor edits, used to recover unsaved work after a crash.
+ * Each running instance owns a session directory, locked for its lifetime, in which every journal
+ * keeps a full snapshot of a generation and the records appended since. Records are buffered and
+ * written and synced to disk periodically. Once the journal outgrows its snapshot, compactionRequested
+ * is emitted and the owner is expected to call compact(), either with a new snapshot or with a compactor
+ * which folds the previous generation into a new snapshot. Either is written in the background, and
+ * compactions requested while one is running are skipped. Sessions whose lock is stale are left over
+ * by a crash and can be recovered by reading the most recent complete snapshot and replaying the records
+ * which follow it.
+ */
+class EditJournal : public QObject {
+	Q_OBJECT
+public:
+	struct Record {
+		quint8 type;
+		QByteArray data;
+	};
+	// Computes a new snapshot from the snapshot and the records of the previous generations, on a worker thread
+	typedef std::function<QByteArray(const QByteArray& snapshot, const QVector<Record>& records)> Compactor;
+
+	EditJournal(const QString& name, QObject* parent = nullptr);
+	~EditJournal();
+
+	bool isActive() const {
+		return m_file.isOpen();
+	}
+	bool reset(const QByteArray& snapshot);
+	void append(quint8 type, const QByteArray& data);
+	void scheduleFlush();
+	void flush();
+	void compact(const QByteArray& snapshot);
+	void compact(const Compactor& compactor);
+	void discard();
+
+	static QStringList crashedSessions();
+	static bool hasJournal(const QString& session, const QString& name);
+	// Reads the most recent complete snapshot below maxGeneration and the records of the journals following it
+	static bool read(const QString& session, const QString& name, QByteArray& snapshot, QVector<Record>& records, int maxGeneration = std::numeric_limits<int>::max());
+	static void removeSession(const QString& session);
+	// Record lists in the format of the journal files, i.e. for snapshots consisting of records
+	static void appendRecord(QByteArray& out, quint8 type, const QByteArray& data);
+	static bool readRecords(const QByteArray& data, int pos, QVector<Record>& records);
+
+signals:
+	void aboutToFlush();
+	void compactionRequested();
+
+private:
+	QString m_name;
+	QFile m_file;
+	bool m_haveFiles = false;
+	int m_generation = 0;
+	QByteArray m_buffer;
+	qint64 m_size = 0;
+	qint64 m_snapshotSize = 0;
+	bool m_compactionRequested = false;
+	QTimer m_flushTimer;
+	QFuture<void> m_sync;
+	QFutureWatcher<qint64> m_compactWatcher;
+	int m_compactGeneration = 0;
+
+	QString filePath(int generation, const QString& suffix) const;
+	bool openJournal(int generation);
+	void closeJournal();
+	bool writeBuffer();
+	void removeFiles(int belowGeneration);
+	void startCompaction(const QByteArray& snapshot, const Compactor& compactor);
+	void compactionFinished();
+
+	static QString rootDir();
+	static QString sessionDir(bool create = true);
+	static QMap<int, QString> generationFiles(const QString& session, const QString& name, const QString& suffix);
+	static bool writeSnapshot(const QString& path, int generation, const QByteArray& snapshot);
+	static bool readSnapshot(const QString& path, int generation, QByteArray& snapshot);
+	static bool readJournal(const QString& path, int generation, QVector<Record>& records);
+	static void syncHandle(int handle);
+};
+
+#endif // EDITJOURNAL_HH
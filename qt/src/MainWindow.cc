@@ -45,6 +45,7 @@
 #include "Displayer.hh"
 #include "DisplayerToolSelect.hh"
 #include "DisplayerToolHOCR.hh"
+#include "EditJournal.hh"
 #include "HOCRBatchExportDialog.hh"
 #include "OutputEditorText.hh"
 #include "OutputEditorHOCR.hh"
@@ -244,6 +245,16 @@ MainWindow::MainWindow(const QStringList& files)
 			ui.dockWidgetOutput->setVisible(true);
 		}
 	}
+
+	// Offer to recover the most recent session which did not exit cleanly, older ones are offered on the next start
+	QStringList crashedSessions = EditJournal::crashedSessions();
+	if(!crashedSessions.isEmpty()) {
+		QString session = crashedSessions.last();
+		addNotification(_("Unsaved output"), _("The unsaved output of a previous session which did not exit cleanly can be recovered."), {
+			{_("Recover"), [this, session]{ recoverSession(session); }, true},
+			{_("Discard"), [session]{ EditJournal::removeSession(session); }, true}
+		});
+	}
 }
 
 MainWindow::~MainWindow() {
@@ -408,6 +419,22 @@ bool MainWindow::setOutputMode(OutputMode mode) {
 	}
 }
 
+void MainWindow::recoverSession(const QString& session) {
+	OutputMode mode = EditJournal::hasJournal(session, "hocr") ? OutputModeHOCR : OutputModeText;
+	if(!setOutputMode(mode)) {
+		return;
+	}
+	// Incompletely recovered sessions are kept, so that recovery can be retried once the missing files are available
+	QString error;
+	if(m_outputEditor->recoverJournal(session, error)) {
+		EditJournal::removeSession(session);
+	} else if(error.isEmpty()) {
+		QMessageBox::warning(this, _("Recovery failed"), _("The unsaved output of the previous session could not be recovered."));
+	} else {
+		QMessageBox::warning(this, _("Recovery incomplete"), _("The unsaved output of the previous session could not be recovered completely.") + "\n\n" + error);
+	}
+}
+
 void MainWindow::addNotification(const QString& title, const QString& message, const QList<NotificationAction>& actions, MainWindow::Notification* handle) {
 	QFrame* frame = new QFrame();
 	frame->setFrameStyle(QFrame::StyledPanel | QFrame::Raised);
@@ -163,6 +163,7 @@ private:
 
 	void closeEvent(QCloseEvent* ev);
 	void setState(State state);
+	void recoverSession(const QString& session);
 
 private slots:
 	void checkVersion(const QString& newver);
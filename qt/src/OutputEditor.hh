@@ -64,6 +64,8 @@ public:
 
 	virtual bool containsSource(const QString& source, int sourcePage) const { return false; }
 	virtual bool crashSave(const QString& filename) const = 0;
+	// Returns true only if everything was recovered, otherwise error may describe what is missing
+	virtual bool recoverJournal(const QString& /*session*/, QString& /*error*/) { return false; }
 
 public slots:
 	virtual void onVisibilityChanged(bool /*visible*/) {}
@@ -17,6 +17,7 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QDataStream>
 #include <QDesktopServices>
 #include <QDir>
 #include <QFile>
@@ -47,7 +48,8 @@ void OutputEditorText::TextBatchProcessor::appendOutput(QIODevice* dev, tesserac
 }
 
 
-OutputEditorText::OutputEditorText() {
+OutputEditorText::OutputEditorText()
+	: m_journal("text") {
 	m_insertMode = InsertMode::Append;
 
 	m_widget = new QWidget;
@@ -88,6 +90,8 @@ OutputEditorText::OutputEditorText() {
 	connect(ui.tabWidget, &QTabWidget::currentChanged, this, &OutputEditorText::tabChanged);
 	connect(ui.tabWidget, &QTabWidget::tabCloseRequested, this, &OutputEditorText::closeTab);
 	connect(ui.toolButtonAddTab, &QToolButton::clicked, this, [this] { addTab(); });
+	connect(&m_journal, &EditJournal::aboutToFlush, this, &OutputEditorText::updateJournal);
+	connect(&m_journal, &EditJournal::compactionRequested, this, [this] { m_journal.compact(journalSnapshot()); });
 
 	addTab();
 
@@ -129,6 +133,11 @@ int OutputEditorText::addTab(const QString& title) {
 	};
 	connect(textEdit->document(), &QTextDocument::modificationChanged, documentChanged);
 	connect(textEdit->document(), &QTextDocument::contentsChanged, documentChanged);
+	connect(textEdit->document(), &QTextDocument::modificationChanged, &m_journal, &EditJournal::scheduleFlush);
+	connect(textEdit->document(), &QTextDocument::contentsChange, this, [this, textEdit](int pos, int removed, int added) { journalEdit(textEdit, pos, removed, added); });
+	int id = ++m_journalTabCounter;
+	m_journalTabs.insert(textEdit, {id, textEdit->document()->revision()});
+	journalAppend(JournalTabAdded, [&](QDataStream & ds) { ds << qint32(id) << tabLabel; });
 	ui.tabWidget->setCurrentIndex(page);
 	return page;
 }
@@ -161,6 +170,9 @@ void OutputEditorText::closeTab(int page) {
 			return;
 		}
 	}
+	int id = m_journalTabs.take(textEdit(page)).id;
+	journalAppend(JournalTabClosed, [&](QDataStream & ds) { ds << qint32(id); });
+	m_journal.scheduleFlush();
 	ui.tabWidget->removeTab(page);
 	if (ui.tabWidget->count() == 0) {
 		m_tabCounter = 0;
@@ -182,6 +194,151 @@ OutputTextEdit* OutputEditorText::textEdit(int page) const {
 	return qobject_cast<OutputTextEdit*>(ui.tabWidget->widget(page));
 }
 
+void OutputEditorText::journalAppend(JournalRecord type, const std::function<void(QDataStream&)>& write) {
+	if(!m_journal.isActive()) {
+		return;
+	}
+	QByteArray data;
+	QDataStream ds(&data, QIODevice::WriteOnly);
+	ds.setVersion(QDataStream::Qt_5_6);
+	write(ds);
+	m_journal.append(type, data);
+}
+
+void OutputEditorText::journalEdit(OutputTextEdit* edit, int pos, int removed, int added) {
+	auto it = m_journalTabs.find(edit);
+	if(it == m_journalTabs.end()) {
+		return;
+	}
+	// Highlighting changes are reported with equal counts, but do not increase the revision
+	QTextDocument* document = edit->document();
+	if(removed == added && document->revision() == it->revision) {
+		return;
+	}
+	it->revision = document->revision();
+	m_journal.scheduleFlush();
+	if(!m_journal.isActive()) {
+		return;
+	}
+	QTextCursor cursor(document);
+	cursor.setPosition(pos);
+	cursor.setPosition(std::min(pos + added, document->characterCount() - 1), QTextCursor::KeepAnchor);
+	QString text = cursor.selectedText().replace(QChar::ParagraphSeparator, '\n');
+	int id = it->id;
+	journalAppend(JournalEdit, [&](QDataStream & ds) { ds << qint32(id) << qint32(pos) << qint32(removed) << text; });
+}
+
+QByteArray OutputEditorText::journalSnapshot() const {
+	QByteArray data;
+	QDataStream ds(&data, QIODevice::WriteOnly);
+	ds.setVersion(QDataStream::Qt_5_6);
+	ds << quint32(ui.tabWidget->count());
+	for(int i = 0, n = ui.tabWidget->count(); i < n; ++i) {
+		OutputTextEdit* edit = textEdit(i);
+		ds << qint32(m_journalTabs.value(edit).id) << tabName(i) << edit->filename() << edit->document()->isModified() << edit->toPlainText();
+	}
+	return data;
+}
+
+void OutputEditorText::updateJournal() {
+	// Only unsaved edits are journaled
+	bool modified = false;
+	for(int i = 0, n = ui.tabWidget->count(); i < n && !modified; ++i) {
+		modified = textEdit(i)->document()->isModified();
+	}
+	if(!modified) {
+		m_journal.discard();
+	} else if(!m_journal.isActive()) {
+		m_journal.reset(journalSnapshot());
+	}
+}
+
+bool OutputEditorText::recoverJournal(const QString& session, QString& /*error*/) {
+	QByteArray snapshot;
+	QVector<EditJournal::Record> records;
+	if(!EditJournal::read(session, "text", snapshot, records)) {
+		return false;
+	}
+	QList<OutputTextEdit*> initialEdits;
+	for(int i = 0, n = ui.tabWidget->count(); i < n; ++i) {
+		initialEdits.append(textEdit(i));
+	}
+	QMap<int, OutputTextEdit*> edits;
+	auto journalTab = [&](int id, const QString& title) {
+		OutputTextEdit*& edit = edits[id];
+		if(!edit) {
+			edit = textEdit(addTab(title));
+		}
+		return edit;
+	};
+
+	QDataStream ds(snapshot);
+	ds.setVersion(QDataStream::Qt_5_6);
+	quint32 count = 0;
+	ds >> count;
+	for(quint32 i = 0; i < count && ds.status() == QDataStream::Ok; ++i) {
+		qint32 id;
+		QString title, filename, text;
+		bool modified;
+		ds >> id >> title >> filename >> modified >> text;
+		OutputTextEdit* edit = journalTab(id, title);
+		edit->setPlainText(text);
+		edit->setFilename(filename);
+		edit->document()->setModified(modified);
+	}
+	for(const EditJournal::Record& record : records) {
+		QDataStream rs(record.data);
+		rs.setVersion(QDataStream::Qt_5_6);
+		qint32 id;
+		rs >> id;
+		if(record.type == JournalTabAdded) {
+			QString title;
+			rs >> title;
+			journalTab(id, title);
+		} else if(record.type == JournalTabFile) {
+			QString title, filename;
+			rs >> title >> filename;
+			OutputTextEdit* edit = journalTab(id, title);
+			edit->setFilename(filename);
+			edit->document()->setModified(false);
+			setTabName(ui.tabWidget->indexOf(edit), title);
+		} else if(record.type == JournalTabClosed) {
+			OutputTextEdit* edit = edits.take(id);
+			if(edit) {
+				m_journalTabs.remove(edit);
+				ui.tabWidget->removeTab(ui.tabWidget->indexOf(edit));
+			}
+		} else if(record.type == JournalEdit) {
+			qint32 pos, removed;
+			QString text;
+			rs >> pos >> removed >> text;
+			QTextDocument* document = journalTab(id, QString())->document();
+			int last = document->characterCount() - 1;
+			QTextCursor cursor(document);
+			cursor.setPosition(qBound(0, int(pos), last));
+			cursor.setPosition(qBound(0, int(pos + removed), last), QTextCursor::KeepAnchor);
+			cursor.insertText(text);
+		}
+	}
+	if(edits.isEmpty()) {
+		return true;
+	}
+	// Drop the empty initial tab
+	for(OutputTextEdit* edit : initialEdits) {
+		if(!edit->document()->isModified() && edit->filename().isEmpty() && edit->document()->isEmpty()) {
+			m_journalTabs.remove(edit);
+			ui.tabWidget->removeTab(ui.tabWidget->indexOf(edit));
+		}
+	}
+	for(OutputTextEdit* edit : edits) {
+		edit->document()->clearUndoRedoStacks();
+	}
+	m_spell.clearUndoRedo();
+	m_journal.flush();
+	MAIN->setOutputPaneVisible(true);
+	return true;
+}
+
 void OutputEditorText::setFont() {
 	QFont font;
 	if(!ConfigSettings::get<SwitchSetting>("systemoutputfont")->getValue()) {
@@ -380,6 +537,9 @@ bool OutputEditorText::open(const QString& filename) {
 			edit->document()->setModified(false);
 			edit->document()->clearUndoRedoStacks();
 			edit->setFilename(file);
+			int id = m_journalTabs.value(edit).id;
+			QString title = tabName(page);
+			journalAppend(JournalTabFile, [&](QDataStream & ds) { ds << qint32(id) << title << file; });
 			currentPage = page;
 		}
 	}
@@ -420,6 +580,10 @@ bool OutputEditorText::save(int page, const QString& filename) {
 	edit->document()->setModified(false);
 	edit->setFilename(outname);
 	setTabName(page, QFileInfo(outname).fileName());
+	int id = m_journalTabs.value(edit).id;
+	QString title = tabName(page);
+	journalAppend(JournalTabFile, [&](QDataStream & ds) { ds << qint32(id) << title << outname; });
+	m_journal.flush();
 	QStringList recentItems = ConfigSettings::get<VarSetting<QStringList>>("recenttxtitems")->getValue();
 	recentItems.removeAll(outname);
 	recentItems.prepend(outname);
@@ -484,6 +648,8 @@ bool OutputEditorText::clear(bool hide) {
 	for(int i = ui.tabWidget->count(); i >= 0; --i) {
 		ui.tabWidget->removeTab(i);
 	}
+	m_journal.discard();
+	m_journalTabs.clear();
 	m_tabCounter = 0;
 	addTab(); // Add one empty tab
 	if(hide) {
@@ -23,6 +23,7 @@
 #include <QtSpell.hpp>
 
 #include "Config.hh"
+#include "EditJournal.hh"
 #include "MainWindow.hh"
 #include "OutputEditor.hh"
 #include "Ui_OutputEditorText.hh"
@@ -52,6 +53,7 @@ public:
 	void readError(const QString& errorMsg, ReadSessionData* data) override;
 	BatchProcessor* createBatchProcessor(const QMap<QString, QVariant>& options) const override { return new TextBatchProcessor(options["prependPage"].toBool()); }
 	bool crashSave(const QString& filename) const override;
+	bool recoverJournal(const QString& session, QString& error) override;
 
 public slots:
 	bool open(const QString& filename = QString()) override;
@@ -66,6 +68,11 @@ private:
 	};
 
 	enum class InsertMode { Append, Cursor, Replace };
+	enum JournalRecord : quint8 { JournalTabAdded = 1, JournalTabFile, JournalTabClosed, JournalEdit };
+	struct JournalTab {
+		int id;
+		int revision;
+	};
 
 	static constexpr int sMaxNumRecent = 15;
 
@@ -75,11 +82,17 @@ private:
 	InsertMode m_insertMode;
 	QtSpell::TextEditChecker m_spell;
 	int m_tabCounter = 0;
+	EditJournal m_journal;
+	QHash<OutputTextEdit*, JournalTab> m_journalTabs;
+	int m_journalTabCounter = 0;
 
 	int addTab(const QString& title = QString());
 	QString tabName(int page) const;
 	void setTabName(int page, const QString& title);
 	OutputTextEdit* textEdit(int page = -1) const;
+	void journalAppend(JournalRecord type, const std::function<void(QDataStream&)>& write);
+	void journalEdit(OutputTextEdit* edit, int pos, int removed, int added);
+	QByteArray journalSnapshot() const;
 
 private slots:
 	void addText(const QString& text, bool insert);
@@ -92,6 +105,7 @@ private slots:
 	void tabChanged(int);
 	void closeTab(int);
 	void prepareRecentMenu();
+	void updateJournal();
 };
 
 #endif // OUTPUTEDITORTEXT_HH
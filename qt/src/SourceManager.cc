@@ -49,6 +49,7 @@
 #include "FileTreeModel.hh"
 #include "MainWindow.hh"
 #include "SourceManager.hh"
+#include "ThumbnailCache.hh"
 #include "Utils.hh"
 
 Source::~Source() {
@@ -495,6 +496,7 @@ void SourceManager::selectRecursive(QItemSelection& parentsel, const QModelIndex
 }
 
 void SourceManager::fileChanged(const QString& filename) {
+	ThumbnailCache::invalidate(filename);
 	if(!QFile(filename).exists()) {
 		QModelIndex index = m_fileTreeModel->findFile(filename);
 		if(index.isValid()) {
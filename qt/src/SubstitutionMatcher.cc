@@ -0,0 +1,118 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * SubstitutionMatcher.cc
+ * Copyright (C) 2022 Sandro Mani <manisandro@gmail.com>
+ *
+ * gImageReader is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gImageReader is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "SubstitutionMatcher.hh"
+
+SubstitutionMatcher::SubstitutionMatcher(const QMap<QString, QString>& substitutions, bool matchCase)
+	: m_matchCase(matchCase) {
+	m_nodes.append(Node());
+	for(auto it = substitutions.begin(), itEnd = substitutions.end(); it != itEnd; ++it) {
+		if(it.key().isEmpty()) {
+			continue;
+		}
+		int node = 0;
+		for(QChar c : it.key()) {
+			c = fold(c);
+			int next = child(node, c);
+			if(next < 0) {
+				next = m_nodes.size();
+				Node newNode;
+				newNode.depth = m_nodes[node].depth + 1;
+				m_nodes.append(newNode);
+				m_nodes[node].children.append(qMakePair(c, next));
+				m_edges.insert(edgeKey(node, c), next);
+			}
+			node = next;
+		}
+		// Search strings which only differ in case are equal when not matching case, keep the first one
+		if(m_nodes[node].pattern < 0) {
+			m_nodes[node].pattern = m_replacements.size();
+			m_replacements.append(it.value());
+		}
+	}
+
+	// Compute the fail links breadth first, each only depends on the links of shallower nodes
+	QVector<int> queue;
+	for(const QPair<QChar, int>& edge : m_nodes[0].children) {
+		queue.append(edge.second);
+	}
+	for(int i = 0; i < queue.size(); ++i) {
+		int node = queue[i];
+		for(const QPair<QChar, int>& edge : m_nodes[node].children) {
+			int fail = m_nodes[node].fail;
+			int target = child(fail, edge.first);
+			while(target < 0 && fail != 0) {
+				fail = m_nodes[fail].fail;
+				target = child(fail, edge.first);
+			}
+			target = std::max(target, 0);
+			m_nodes[edge.second].fail = target;
+			m_nodes[edge.second].output = m_nodes[target].pattern >= 0 ? target : m_nodes[target].output;
+			queue.append(edge.second);
+		}
+	}
+}
+
+int SubstitutionMatcher::apply(QString& text) const {
+	if(m_replacements.isEmpty()) {
+		return 0;
+	}
+	// Node of the longest match starting at each position, only allocated once something matches
+	QVector<int> matches;
+	int node = 0;
+	for(int i = 0, n = text.size(); i < n; ++i) {
+		QChar c = fold(text[i]);
+		int next = child(node, c);
+		while(next < 0 && node != 0) {
+			node = m_nodes[node].fail;
+			next = child(node, c);
+		}
+		node = std::max(next, 0);
+		int match = m_nodes[node].pattern >= 0 ? node : m_nodes[node].output;
+		for(; match >= 0; match = m_nodes[match].output) {
+			if(matches.isEmpty()) {
+				matches.fill(-1, n);
+			}
+			int start = i + 1 - m_nodes[match].depth;
+			if(matches[start] < 0 || m_nodes[matches[start]].depth < m_nodes[match].depth) {
+				matches[start] = match;
+			}
+		}
+	}
+	if(matches.isEmpty()) {
+		return 0;
+	}
+	QString result;
+	result.reserve(text.size());
+	int count = 0;
+	for(int i = 0, n = text.size(); i < n;) {
+		int match = matches[i];
+		if(match >= 0) {
+			result.append(m_replacements[m_nodes[match].pattern]);
+			i += m_nodes[match].depth;
+			++count;
+		} else {
+			result.append(text[i++]);
+		}
+	}
+	text = result;
+	return count;
+}
@@ -0,0 +1,64 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * SubstitutionMatcher.hh
+ * Copyright (C) 2022 Sandro Mani <manisandro@gmail.com>
+ *
+ * gImageReader is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gImageReader is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SUBSTITUTIONMATCHER_HH
+#define SUBSTITUTIONMATCHER_HH
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+// Aho-Corasick automaton over a list of substitutions, which finds the occurrences of all
+// search strings in a single pass over the text
+class SubstitutionMatcher {
+public:
+	SubstitutionMatcher(const QMap<QString, QString>& substitutions, bool matchCase);
+	bool isEmpty() const {
+		return m_replacements.isEmpty();
+	}
+	// Replaces the leftmost longest non-overlapping matches, returns the number of replacements
+	int apply(QString& text) const;
+
+private:
+	struct Node {
+		int fail = 0;
+		int output = -1; // Nearest node along the fail links which completes a search string
+		int pattern = -1;
+		int depth = 0;
+		QVector<QPair<QChar, int>> children;
+	};
+
+	bool m_matchCase;
+	QVector<Node> m_nodes;
+	QHash<quint64, int> m_edges;
+	QVector<QString> m_replacements;
+
+	QChar fold(QChar c) const {
+		return m_matchCase ? c : c.toCaseFolded();
+	}
+	static quint64 edgeKey(int node, QChar c) {
+		return (quint64(node) << 16) | c.unicode();
+	}
+	int child(int node, QChar c) const {
+		return m_edges.value(edgeKey(node, c), -1);
+	}
+};
+
+#endif // SUBSTITUTIONMATCHER_HH
@@ -0,0 +1,139 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * ThumbnailCache.cc
+ * Copyright (C) 2022 Sandro Mani <manisandro@gmail.com>
+ *
+ * gImageReader is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gImageReader is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+
+#include "ThumbnailCache.hh"
+
+// Disk space the thumbnails may use
+static const qint64 s_maxCacheSize = 256 * 1024 * 1024;
+static QMutex s_cacheSizeMutex;
+// Total size of the thumbnails, -1 if not known yet
+static qint64 s_cacheSize = -1;
+
+QImage ThumbnailCache::load(const QString& filename, int page) {
+	QFileInfo finfo(filename);
+	if(!finfo.exists()) {
+		return QImage();
+	}
+	QString path = thumbnailPath(filename, page);
+	QImageReader reader(path, "png");
+	if(!reader.canRead()) {
+		return QImage();
+	}
+	if(reader.text("Thumb::URI") != fileUri(filename) ||
+	        reader.text("Thumb::MTime") != QString::number(finfo.lastModified().toSecsSinceEpoch()) ||
+	        reader.text("Thumb::Size") != QString::number(finfo.size())) {
+		return QImage();
+	}
+	QImage image = reader.read();
+	// The modification time of the thumbnail records its last use, which determines the eviction order
+	QFile file(path);
+	if(!image.isNull() && file.open(QIODevice::Append)) {
+		file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+	}
+	return image;
+}
+
+void ThumbnailCache::store(const QString& filename, int page, const QImage& image) {
+	QFileInfo finfo(filename);
+	if(image.isNull() || !finfo.exists() || !QDir().mkpath(cacheDir())) {
+		return;
+	}
+	// Write to a temporary file which is atomically renamed, so that concurrent readers never see partial thumbnails
+	QString path = thumbnailPath(filename, page);
+	QSaveFile file(path);
+	if(!file.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	QImageWriter writer(&file, "png");
+	writer.setText("Thumb::URI", fileUri(filename));
+	writer.setText("Thumb::MTime", QString::number(finfo.lastModified().toSecsSinceEpoch()));
+	writer.setText("Thumb::Size", QString::number(finfo.size()));
+	writer.setText("Thumb::Page", QString::number(page));
+	writer.setText("Software", PACKAGE_NAME);
+	if(!writer.write(image)) {
+		file.cancelWriting();
+	} else if(file.commit()) {
+		trim(QFileInfo(path).size());
+	}
+}
+
+void ThumbnailCache::invalidate(const QString& filename) {
+	QDir dir(cacheDir());
+	for(const QString& entry : dir.entryList({QString("%1-*.png").arg(cacheKey(filename))}, QDir::Files)) {
+		dir.remove(entry);
+	}
+	QMutexLocker locker(&s_cacheSizeMutex);
+	s_cacheSize = -1;
+}
+
+QString ThumbnailCache::cacheDir() {
+	return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).absoluteFilePath("thumbnails");
+}
+
+QString ThumbnailCache::fileUri(const QString& filename) {
+	return QUrl::fromLocalFile(QFileInfo(filename).absoluteFilePath()).toString(QUrl::FullyEncoded);
+}
+
+QString ThumbnailCache::cacheKey(const QString& filename) {
+	return QString::fromLatin1(QCryptographicHash::hash(fileUri(filename).toUtf8(), QCryptographicHash::Md5).toHex());
+}
+
+QString ThumbnailCache::thumbnailPath(const QString& filename, int page) {
+	return QDir(cacheDir()).absoluteFilePath(QString("%1-%2.png").arg(cacheKey(filename)).arg(page));
+}
+
+void ThumbnailCache::trim(qint64 added) {
+	QMutexLocker locker(&s_cacheSizeMutex);
+	if(s_cacheSize >= 0) {
+		s_cacheSize += added;
+		if(s_cacheSize <= s_maxCacheSize) {
+			return;
+		}
+	}
+	// The size is only tracked approximately (i.e. replaced thumbnails are counted twice), determine it from the files
+	QFileInfoList entries = QDir(cacheDir()).entryInfoList({"*.png"}, QDir::Files, QDir::Time | QDir::Reversed);
+	qint64 total = 0;
+	for(const QFileInfo& entry : entries) {
+		total += entry.size();
+	}
+	// Remove the least recently used thumbnails until well below the limit, so that the files are not scanned on every store
+	if(total > s_maxCacheSize) {
+		for(const QFileInfo& entry : entries) {
+			if(total <= s_maxCacheSize * 3 / 4) {
+				break;
+			}
+			if(QFile::remove(entry.absoluteFilePath())) {
+				total -= entry.size();
+			}
+		}
+	}
+	s_cacheSize = total;
+}
@@ -0,0 +1,48 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * ThumbnailCache.hh
+ * Copyright (C) 2022 Sandro Mani <manisandro@gmail.com>
+ *
+ * gImageReader is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gImageReader is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THUMBNAILCACHE_HH
+#define THUMBNAILCACHE_HH
+
+#include <QImage>
+#include <QString>
+
+/**
+ * On-disk cache of page thumbnails.
+ * Thumbnails are stored as PNG files named after the MD5 hash of the source URI and the page number,
+ * and carry the Thumb::URI, Thumb::MTime and Thumb::Size keys of the freedesktop thumbnail
+ * specification, which are used to validate them against the source file when loading.
+ * The cache is limited in size, the least recently used thumbnails are removed when it grows beyond.
+ * All methods are thread-safe.
+ */
+class ThumbnailCache {
+public:
+	static QImage load(const QString& filename, int page);
+	static void store(const QString& filename, int page, const QImage& image);
+	static void invalidate(const QString& filename);
+
+private:
+	static QString cacheDir();
+	static QString fileUri(const QString& filename);
+	static QString cacheKey(const QString& filename);
+	static QString thumbnailPath(const QString& filename, int page);
+	static void trim(qint64 added);
+};
+
+#endif // THUMBNAILCACHE_HH
@@ -210,19 +210,23 @@ QByteArray Utils::download(QUrl url, QString& messages, int timeout) {
 }
 
 QString Utils::getSpellingLanguage(const QString& lang, const QString& defaultLanguage) {
+	return getSpellingLanguage(lang, defaultLanguage, MAIN->getConfig()->langSpecs());
+}
+
+QString Utils::getSpellingLanguage(const QString& lang, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs) {
 	// If it is already a valid code, return it
 	if(QRegularExpression("^[a-z]{2}(_[A-Z]{2})?$").match(lang).hasMatch()) {
 		return lang;
 	}
 	// Treat the language as a tesseract lang spec and try to find a matching code
 	Config::Lang langspec = {lang, "", ""};
-	if(!lang.isEmpty() && MAIN->getConfig()->searchLangSpec(langspec)) {
+	if(!lang.isEmpty() && Config::searchLangSpec(langspec, langSpecs)) {
 		// If default language starts with the returned code, return default language
 		if(!defaultLanguage.isEmpty() && defaultLanguage.startsWith(langspec.code)) {
 			return defaultLanguage;
 		}
 		// Return any one language culture code
-		QStringList langCultures = MAIN->getConfig()->searchLangCultures(langspec.code);
+		QStringList langCultures = Config::searchLangCultures(langspec.code);
 		if(!langCultures.isEmpty()) {
 			return langCultures.front();
 		}
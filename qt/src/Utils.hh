@@ -29,6 +29,8 @@
 #include <QString>
 #include <QWaitCondition>
 
+#include "Config.hh"
+
 class QMimeData;
 class QSpinBox;
 class QDoubleSpinBox;
@@ -57,6 +59,8 @@ void handleSourceDropEvent(const QMimeData* mimeData);
 QByteArray download(QUrl url, QString& messages, int timeout = 60000);
 
 QString getSpellingLanguage(const QString& lang = QString(), const QString& defaultLanguage = QString());
+// Thread-safe variant, looking up the language in a copy of the language definitions
+QString getSpellingLanguage(const QString& lang, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs);
 
 class TesseractHandle {
 public:
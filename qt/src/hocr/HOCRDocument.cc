@@ -17,45 +17,401 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QBuffer>
+#include <QDataStream>
 #include <QDir>
 #include <QDomElement>
+#include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QMenu>
+#include <QMutex>
 #include <QIcon>
+#include <QReadWriteLock>
 #include <QSet>
+#include <QThread>
+#include <QVarLengthArray>
+#include <QXmlStreamReader>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
 
 #include "common.hh"
 #include "HOCRDocument.hh"
 #include "HOCRSpellChecker.hh"
 #include "Utils.hh"
 
+// Accumulates UTF-8 output in a fixed size buffer which is written out whenever it fills up
+class HOCRHtmlWriter {
+public:
+	HOCRHtmlWriter(QIODevice* dev) : m_dev(dev) {
+		m_buffer.reserve(BufferSize);
+	}
+	~HOCRHtmlWriter() {
+		flush();
+	}
+	HOCRHtmlWriter& operator<<(const char* str) {
+		m_buffer.append(str);
+		return checkFlush();
+	}
+	HOCRHtmlWriter& operator<<(const QString& str) {
+		m_buffer.append(str.toUtf8());
+		return checkFlush();
+	}
+	HOCRHtmlWriter& operator<<(const QByteArray& str) {
+		m_buffer.append(str);
+		return checkFlush();
+	}
+	HOCRHtmlWriter& operator<<(int value) {
+		char digits[12];
+		char* pos = digits + sizeof(digits);
+		unsigned int abs = value < 0 ? 0u - unsigned(value) : unsigned(value);
+		do {
+			*--pos = char('0' + abs % 10);
+			abs /= 10;
+		} while(abs > 0);
+		if(value < 0) {
+			*--pos = '-';
+		}
+		m_buffer.append(pos, int(digits + sizeof(digits) - pos));
+		return checkFlush();
+	}
+	HOCRHtmlWriter& indent(int indent) {
+		m_buffer.append(indent, ' ');
+		return *this;
+	}
+	bool ok() const {
+		return m_ok;
+	}
+	bool flush() {
+		if(m_ok && !m_buffer.isEmpty()) {
+			m_ok = m_dev->write(m_buffer) == m_buffer.size();
+		}
+		// resize rather than clear to keep the reserved capacity
+		m_buffer.resize(0);
+		return m_ok;
+	}
+
+private:
+	static constexpr int BufferSize = 256 * 1024;
+	QIODevice* m_dev;
+	QByteArray m_buffer;
+	bool m_ok = true;
+
+	HOCRHtmlWriter& checkFlush() {
+		if(m_buffer.size() >= BufferSize - 4096) {
+			flush();
+		}
+		return *this;
+	}
+};
+
+// Binary serialization of items: the strings are collected in a table which precedes the
+// payload, so that repeated attribute names and values are stored (and loaded) only once
+class HOCRBinaryWriter {
+public:
+	HOCRBinaryWriter() : m_stream(&m_payload, QIODevice::WriteOnly) {
+		m_stream.setVersion(QDataStream::Qt_5_6);
+		m_stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+	}
+	QDataStream& stream() {
+		return m_stream;
+	}
+	void writeString(const QString& str) {
+		auto it = m_strings.find(str);
+		if(it == m_strings.end()) {
+			it = m_strings.insert(str, m_table.size());
+			m_table.append(str);
+		}
+		m_stream << it.value();
+	}
+	QByteArray finish() const {
+		QByteArray data;
+		QDataStream ds(&data, QIODevice::WriteOnly);
+		ds.setVersion(QDataStream::Qt_5_6);
+		ds << m_table;
+		data.append(m_payload);
+		return data;
+	}
+
+private:
+	QByteArray m_payload;
+	QDataStream m_stream;
+	QHash<QString, quint32> m_strings;
+	QVector<QString> m_table;
+};
+
+class HOCRBinaryReader {
+public:
+	HOCRBinaryReader(const QByteArray& data) : m_stream(data) {
+		m_stream.setVersion(QDataStream::Qt_5_6);
+		m_stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+		m_stream >> m_table;
+	}
+	QDataStream& stream() {
+		return m_stream;
+	}
+	QString readString() {
+		quint32 idx = 0;
+		m_stream >> idx;
+		if(idx >= quint32(m_table.size())) {
+			m_stream.setStatus(QDataStream::ReadCorruptData);
+			return QString();
+		}
+		return m_table[idx];
+	}
+	bool ok() const {
+		return m_stream.status() == QDataStream::Ok;
+	}
+
+private:
+	QDataStream m_stream;
+	QVector<QString> m_table;
+};
+
+// Parsing of the properties of hOCR title attributes directly on the UTF-16 data, without temporary strings
+
+static const QChar* skipSpace(const QChar* pos, const QChar* end) {
+	while(pos < end && pos->isSpace()) {
+		++pos;
+	}
+	return pos;
+}
+
+static bool isDigit(const QChar* pos, const QChar* end) {
+	return pos < end && pos->unicode() >= '0' && pos->unicode() <= '9';
+}
+
+static bool parseNumber(const QChar*& pos, const QChar* end, int& value) {
+	bool negative = pos < end && *pos == '-';
+	if(pos < end && (*pos == '-' || *pos == '+')) {
+		++pos;
+	}
+	if(!isDigit(pos, end)) {
+		return false;
+	}
+	qint64 result = 0;
+	while(isDigit(pos, end) && result <= std::numeric_limits<int>::max()) {
+		result = result * 10 + (pos++->unicode() - '0');
+	}
+	if(result > std::numeric_limits<int>::max()) {
+		return false;
+	}
+	value = int(negative ? -result : result);
+	return true;
+}
+
+static bool parseNumber(const QChar*& pos, const QChar* end, float& value) {
+	bool negative = pos < end && *pos == '-';
+	if(pos < end && (*pos == '-' || *pos == '+')) {
+		++pos;
+	}
+	bool haveDigits = isDigit(pos, end);
+	double result = 0;
+	while(isDigit(pos, end)) {
+		result = result * 10 + (pos++->unicode() - '0');
+	}
+	// Depending on the locale, tesseract can use a comma instead of a dot as decimal separator
+	if(pos < end && (*pos == '.' || *pos == ',')) {
+		++pos;
+		haveDigits |= isDigit(pos, end);
+		double fraction = 0;
+		double scale = 1;
+		while(isDigit(pos, end)) {
+			fraction = fraction * 10 + (pos++->unicode() - '0');
+			scale *= 10;
+		}
+		result += fraction / scale;
+	}
+	if(!haveDigits) {
+		return false;
+	}
+	if(pos < end && (*pos == 'e' || *pos == 'E')) {
+		int exponent = 0;
+		if(!parseNumber(++pos, end, exponent)) {
+			return false;
+		}
+		result *= std::pow(10., exponent);
+	}
+	value = float(negative ? -result : result);
+	return true;
+}
+
+// Parses exactly count whitespace separated numbers
+template<class T>
+static bool parseNumbers(QStringView str, T* values, int count) {
+	const QChar* pos = str.begin();
+	const QChar* end = str.end();
+	for(int i = 0; i < count; ++i) {
+		pos = skipSpace(pos, end);
+		if(!parseNumber(pos, end, values[i]) || (pos < end && !pos->isSpace())) {
+			return false;
+		}
+	}
+	return skipSpace(pos, end) == end;
+}
+
+// Textual form of the parsed fractional title attributes
+static QString formatNumbers(const float* values, int count) {
+	QString result = QString::number(values[0], 'g', 7);
+	for(int i = 1; i < count; ++i) {
+		result += QLatin1Char(' ') + QString::number(values[i], 'g', 7);
+	}
+	return result;
+}
+
+// Whether value is the formatted text, up to commas as decimal separator which are written as dots
+static bool matchesFormatted(QStringView value, const QString& text) {
+	if(value.size() != text.size()) {
+		return false;
+	}
+	for(int i = 0, n = value.size(); i < n; ++i) {
+		if((value[i] == ',' ? QChar('.') : value[i]) != text[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Iterates over the properties of a title attribute, i.e. "bbox 0 0 10 10; x_wconf 95".
+// The name and value are views into the attribute string.
+class HOCRTitleTokenizer {
+public:
+	HOCRTitleTokenizer(QStringView title) : m_pos(title.begin()), m_end(title.end()) {}
+	bool next() {
+		while(m_pos < m_end) {
+			const QChar* start = skipSpace(m_pos, m_end);
+			const QChar* nameEnd = start;
+			while(nameEnd < m_end && !nameEnd->isSpace() && *nameEnd != ';') {
+				++nameEnd;
+			}
+			const QChar* valueStart = skipSpace(nameEnd, m_end);
+			const QChar* stop = std::find(valueStart, m_end, QChar(';'));
+			// Quoted values (i.e. image paths) may contain semicolons and quotes, they only end at a matching
+			// quote which is followed by the end of the property. Unterminated quotes are not treated specially.
+			if(valueStart < m_end && (*valueStart == '\'' || *valueStart == '"')) {
+				for(const QChar* pos = valueStart + 1; pos < m_end; ++pos) {
+					if(*pos == *valueStart) {
+						const QChar* next = skipSpace(pos + 1, m_end);
+						if(next == m_end || *next == ';') {
+							stop = next;
+							break;
+						}
+					}
+				}
+			}
+			m_pos = stop < m_end ? stop + 1 : stop;
+			while(stop > start && (stop - 1)->isSpace()) {
+				--stop;
+			}
+			if(start == stop) {
+				continue;
+			}
+			m_name = QStringView(start, nameEnd);
+			m_value = QStringView(skipSpace(nameEnd, stop), stop);
+			return true;
+		}
+		return false;
+	}
+	QStringView name() const {
+		return m_name;
+	}
+	QStringView value() const {
+		return m_value;
+	}
+
+private:
+	const QChar* m_pos;
+	const QChar* m_end;
+	QStringView m_name;
+	QStringView m_value;
+};
+
+static constexpr quint32 s_projectMagic = 0x47494850; // "GIHP"
+static constexpr quint32 s_projectVersion = 1;
+
+// Words below this confidence are listed for navigation
+static constexpr int s_lowConfidence = 90;
+
+// Guards the evicted children of pages, exporters may access pages from a worker thread while the view accesses them
+static QMutex s_evictionMutex;
+
+// Visits the items below item in document order, until visitor returns false
+static bool visitItems(const HOCRItem* item, const std::function<bool(const HOCRItem*)>& visitor) {
+	for(const HOCRItem* child : item->children()) {
+		if(!visitor(child) || !visitItems(child, visitor)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 
 HOCRDocument::HOCRDocument(QObject* parent)
 	: QAbstractItemModel(parent) {
 	m_spell = new HOCRSpellChecker(this);
+	// Used by the (single) thread of m_spellPool, guarded by m_dictMutex like m_spell
+	m_bgSpell = new HOCRSpellChecker();
+	m_spellPool.setMaxThreadCount(1);
+	connect(this, &HOCRDocument::spellCheckDone, this, &HOCRDocument::spellCheckFinished, Qt::QueuedConnection);
+	m_evictTimer.setSingleShot(true);
+	m_evictTimer.setInterval(1000);
+	connect(&m_evictTimer, &QTimer::timeout, this, &HOCRDocument::evictPages);
+	// In the order of HOCRItem::ItemClass
+	m_classIcons = {QIcon(":/icons/item_page"), QIcon(":/icons/item_block"), QIcon(":/icons/item_par"), QIcon(":/icons/item_line"), QIcon(":/icons/item_word"), QIcon(":/icons/item_halftone"), QIcon()};
+	m_classLabels = {_("Page"), _("Text block"), _("Paragraph"), _("Textline"), QString(), _("Graphic"), QString()};
 }
 
 HOCRDocument::~HOCRDocument() {
+	m_spellGeneration.ref();
+	m_spellPool.clear();
+	m_spellPool.waitForDone();
+	delete m_bgSpell;
 	qDeleteAll(m_pages);
+	m_projectData.clear();
+	for(const auto& projectFile : m_projectFiles) {
+		delete projectFile.first;
+	}
 }
 
 void HOCRDocument::clear() {
 	beginResetModel();
+	m_spellQueue.clear();
+	m_spellDeferred.clear();
+	m_spellPage = nullptr;
+	m_spellGeneration.ref();
 	qDeleteAll(m_pages);
 	m_pages.clear();
-	m_pageIdCounter = 0;
+	m_projectData.clear();
+	for(const auto& projectFile : m_projectFiles) {
+		delete projectFile.first;
+	}
+	m_projectFiles.clear();
+	m_sourcePages.clear();
+	m_sourceRefCount.clear();
+	m_pageIdCounter.storeRelease(0);
+	m_pendingChanges.clear();
+	m_pendingChangeIds.clear();
+	m_pendingAttributeChanges.clear();
+	m_pendingAttributeChangeIds.clear();
 	endResetModel();
 }
 
 void HOCRDocument::resetMisspelled(const QModelIndex& index) {
+	// One notification per parent instead of one per word
+	BulkEdit bulkEdit(this);
 	if(hasChildren(index)) {
 		for(int i = 0, n = rowCount(index); i < n; ++i) {
 			resetMisspelled(this->index(i, 0, index));
 		}
 	} else {
 		mutableItemAtIndex(index)->setMisspelled(-1);
-		emit dataChanged(index, index, {Qt::ForegroundRole});
+		notifyDataChanged(index, index, {Qt::ForegroundRole});
 	}
 }
 
@@ -73,11 +429,19 @@ void HOCRDocument::addSpellingActions(QMenu* menu, const QModelIndex& index) {
 		if(!valid) {
 			menu->addSeparator();
 			menu->addAction(_("Add to dictionary"), menu, [this, trimmedWord, index] {
-				m_spell->addWordToDictionary(trimmedWord);
+				{
+					QMutexLocker locker(&m_dictMutex);
+					m_spell->addWordToDictionary(trimmedWord);
+				}
+				ignoreSpelling(trimmedWord);
 				resetMisspelled(index);
 			});
 			menu->addAction(_("Ignore word"), menu, [this, trimmedWord, index] {
-				m_spell->ignoreWord(trimmedWord);
+				{
+					QMutexLocker locker(&m_dictMutex);
+					m_spell->ignoreWord(trimmedWord);
+				}
+				ignoreSpelling(trimmedWord);
 				resetMisspelled(index);
 			});
 		}
@@ -88,33 +452,572 @@ void HOCRDocument::addWordToDictionary(const QModelIndex& index) {
 	const HOCRItem* item = itemAtIndex(index);
 	if(item && item->isMisspelled()) {
 		QString trimmedWord = HOCRItem::trimmedWord(item->text());
-		m_spell->addWordToDictionary(trimmedWord);
+		{
+			QMutexLocker locker(&m_dictMutex);
+			m_spell->addWordToDictionary(trimmedWord);
+		}
+		ignoreSpelling(trimmedWord);
 		resetMisspelled(index);
 	}
 }
 
 QString HOCRDocument::toHTML() const {
-	QString html = "<body>\n";
+	QByteArray html;
+	QBuffer buffer(&html);
+	buffer.open(QIODevice::WriteOnly);
+	writeHTML(&buffer);
+	return QString::fromUtf8(html);
+}
+
+bool HOCRDocument::writeHTML(QIODevice* dev) const {
+	HOCRHtmlWriter writer(dev);
+	writer << "<body>\n";
 	for(const HOCRPage* page : m_pages) {
-		html += page->toHtml(1);
+		// Evicted pages are left evicted, this is also called from the crash handler
+		page->writeHtmlDetached(writer, 1);
+		if(!writer.ok()) {
+			return false;
+		}
 	}
-	html += "</body>\n";
-	return html;
+	writer << "</body>\n";
+	return writer.flush();
 }
 
 
-QModelIndex HOCRDocument::insertPage(int beforeIdx, const QDomElement& pageElement, bool cleanGraphics, const QString& sourceBasePath) {
-	beginInsertRows(QModelIndex(), beforeIdx, beforeIdx);
-	m_pages.insert(beforeIdx, new HOCRPage(pageElement, ++m_pageIdCounter, m_defaultLanguage, cleanGraphics, beforeIdx));
+QModelIndex HOCRDocument::insertPage(int beforeIdx, const QDomElement& pageElement, bool cleanGraphics, const QList<Config::Lang>& langSpecs, const QString& sourceBasePath) {
+	HOCRPage* page = new HOCRPage(pageElement, ++m_pageIdCounter, m_defaultLanguage, langSpecs, cleanGraphics, beforeIdx);
 	if(!sourceBasePath.isEmpty()) {
-		m_pages[beforeIdx]->convertSourcePath(sourceBasePath, true);
+		page->convertSourcePath(sourceBasePath, true);
+	}
+	return insertPage(beforeIdx, page);
+}
+
+QModelIndex HOCRDocument::insertPage(int beforeIdx, HOCRPage* page) {
+	insertPages(beforeIdx, {page});
+	return index(beforeIdx, 0);
+}
+
+bool HOCRDocument::writeProject(QIODevice* dev) const {
+	QDataStream ds(dev);
+	ds.setVersion(QDataStream::Qt_5_6);
+	ds << s_projectMagic << s_projectVersion;
+	QVector<quint64> offsets;
+	offsets.reserve(m_pages.size());
+	for(const HOCRPage* page : m_pages) {
+		offsets.append(dev->pos());
+		QByteArray data = serializePage(page);
+		if(ds.writeRawData(data.constData(), data.size()) != data.size()) {
+			return false;
+		}
+	}
+	// The page table follows the pages so that the file can be written in one pass
+	quint64 tableOffset = dev->pos();
+	ds << offsets << tableOffset;
+	return ds.status() == QDataStream::Ok;
+}
+
+bool HOCRDocument::isProjectFile(const QString& filename) {
+	QFile file(filename);
+	if(!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	QDataStream ds(&file);
+	quint32 magic = 0;
+	ds >> magic;
+	return magic == s_projectMagic;
+}
+
+QByteArray HOCRDocument::serializePage(const HOCRPage* page) const {
+	QByteArray data;
+	QDataStream ds(&data, QIODevice::WriteOnly);
+	ds.setVersion(QDataStream::Qt_5_6);
+	HOCRBinaryWriter record;
+	page->writeBinary(record, false);
+	// Evicted pages are written as they are, without restoring them
+	ds << record.finish() << quint32(page->childCount()) << (page->isEvicted() ? page->m_evictedChildren : page->serializeChildren());
+	return data;
+}
+
+HOCRPage* HOCRDocument::deserializePage(const QByteArray& data) {
+	QDataStream ds(data);
+	ds.setVersion(QDataStream::Qt_5_6);
+	QByteArray record;
+	quint32 childCount = 0;
+	QByteArray children;
+	ds >> record >> childCount >> children;
+	if(ds.status() != QDataStream::Ok) {
+		return nullptr;
+	}
+	HOCRBinaryReader reader(record);
+	HOCRPage* page = new HOCRPage(reader, ++m_pageIdCounter, -1);
+	if(!reader.ok()) {
+		delete page;
+		return nullptr;
+	}
+	// As for project files, the children are deserialized when they are accessed
+	page->m_evictedChildren = children;
+	page->m_evictedChildCount = childCount;
+	page->m_childrenEvicted.storeRelease(1);
+	return page;
+}
+
+bool HOCRDocument::readProject(const QString& filename, QVector<HOCRPage*>& pages, const QString& sourceBasePath) {
+	QFile* file = new QFile(filename);
+	if(!file->open(QIODevice::ReadOnly)) {
+		delete file;
+		return false;
+	}
+	QByteArray data;
+	uchar* map = file->map(0, file->size());
+	if(map) {
+		data = QByteArray::fromRawData(reinterpret_cast<const char*>(map), file->size());
+	} else {
+		data = file->readAll();
+	}
+	if(!readProject(data, pages, sourceBasePath)) {
+		delete file;
+		return false;
+	}
+	m_projectFiles.append(qMakePair(file, m_projectData.takeLast()));
+	return true;
+}
+
+void HOCRDocument::releaseProjectFile(const QString& filename) {
+	QString path = QFileInfo(filename).absoluteFilePath();
+	for(int i = m_projectFiles.size() - 1; i >= 0; --i) {
+		if(QFileInfo(m_projectFiles[i].first->fileName()).absoluteFilePath() != path) {
+			continue;
+		}
+		quintptr begin = quintptr(m_projectFiles[i].second.constData());
+		quintptr end = begin + m_projectFiles[i].second.size();
+		QMutexLocker locker(&s_evictionMutex);
+		for(HOCRPage* page : m_pages) {
+			quintptr children = quintptr(page->m_evictedChildren.constData());
+			if(page->isEvicted() && children >= begin && children < end) {
+				page->m_evictedChildren = QByteArray(page->m_evictedChildren.constData(), page->m_evictedChildren.size());
+			}
+		}
+		delete m_projectFiles[i].first;
+		m_projectFiles.removeAt(i);
+	}
+}
+
+bool HOCRDocument::readProject(const QByteArray& data, QVector<HOCRPage*>& pages, const QString& sourceBasePath) {
+	QDataStream ds(data);
+	ds.setVersion(QDataStream::Qt_5_6);
+	quint32 magic = 0;
+	quint32 version = 0;
+	quint64 tableOffset = 0;
+	QVector<quint64> offsets;
+	ds >> magic >> version;
+	if(magic == s_projectMagic && version == s_projectVersion && data.size() >= 16) {
+		ds.device()->seek(data.size() - 8);
+		ds >> tableOffset;
+		if(tableOffset < quint64(data.size()) && ds.device()->seek(tableOffset)) {
+			ds >> offsets;
+		} else {
+			ds.setStatus(QDataStream::ReadCorruptData);
+		}
+	} else {
+		ds.setStatus(QDataStream::ReadCorruptData);
+	}
+
+	QVector<HOCRPage*> projectPages;
+	for(quint64 offset : offsets) {
+		if(offset >= quint64(data.size()) || !ds.device()->seek(offset)) {
+			ds.setStatus(QDataStream::ReadCorruptData);
+			break;
+		}
+		QByteArray record;
+		quint32 childCount = 0;
+		quint32 size = 0;
+		ds >> record >> childCount >> size;
+		qint64 pos = ds.device()->pos();
+		if(ds.status() != QDataStream::Ok || pos + size > data.size()) {
+			ds.setStatus(QDataStream::ReadCorruptData);
+			break;
+		}
+		HOCRBinaryReader reader(record);
+		HOCRPage* page = new HOCRPage(reader, ++m_pageIdCounter, -1);
+		projectPages.append(page);
+		if(!reader.ok()) {
+			ds.setStatus(QDataStream::ReadCorruptData);
+			break;
+		}
+		page->convertSourcePath(sourceBasePath, true);
+		// The children are only deserialized from the mapped file when they are accessed
+		page->m_evictedChildren = QByteArray::fromRawData(data.constData() + pos, size);
+		page->m_evictedChildCount = childCount;
+		page->m_childrenEvicted.storeRelease(1);
+	}
+	if(ds.status() != QDataStream::Ok) {
+		qDeleteAll(projectPages);
+		return false;
+	}
+	pages.append(projectPages);
+	m_projectData.append(data);
+	return true;
+}
+
+void HOCRDocument::setMemoryCap(qint64 bytes) {
+	m_memoryCap = bytes;
+	m_evictTimer.start();
+}
+
+void HOCRDocument::pinPage(int pageId, bool pin) {
+	int& count = m_pinnedPages[pageId];
+	count += pin ? 1 : -1;
+	if(count <= 0) {
+		m_pinnedPages.remove(pageId);
+		m_evictTimer.start();
+	}
+}
+
+void HOCRDocument::clearModified() {
+	for(HOCRPage* page : m_pages) {
+		page->m_modified = false;
+	}
+	m_evictTimer.start();
+}
+
+void HOCRDocument::blockEviction(bool block) {
+	m_evictionBlocked += block ? 1 : -1;
+	if(m_evictionBlocked == 0) {
+		m_evictTimer.start();
+	}
+}
+
+void HOCRDocument::beginBulkEdit() {
+	++m_bulkEditDepth;
+}
+
+void HOCRDocument::endBulkEdit() {
+	if(--m_bulkEditDepth > 0) {
+		return;
+	}
+	QVector<PendingChange> changes;
+	changes.swap(m_pendingChanges);
+	m_pendingChangeIds.clear();
+	QVector<PendingAttributeChange> attributeChanges;
+	attributeChanges.swap(m_pendingAttributeChanges);
+	m_pendingAttributeChangeIds.clear();
+	for(const PendingChange& change : changes) {
+		if(!change.topLevel && !change.parent.isValid()) {
+			continue;
+		}
+		// If the outermost changed rows were removed in the meantime, fall back to all rows of the parent
+		QModelIndex parent = change.parent;
+		int firstRow = change.first.isValid() ? change.first.row() : 0;
+		int lastRow = change.last.isValid() ? change.last.row() : rowCount(parent) - 1;
+		if(firstRow <= lastRow) {
+			emit dataChanged(index(firstRow, change.firstColumn, parent), index(lastRow, change.lastColumn, parent), change.roles);
+		}
+	}
+	for(const PendingAttributeChange& change : attributeChanges) {
+		if(change.index.isValid()) {
+			emit itemAttributeChanged(change.index, change.name, change.value);
+		}
+	}
+}
+
+void HOCRDocument::notifyDataChanged(const QModelIndex& first, const QModelIndex& last, const QVector<int>& roles) {
+	QModelIndex parent = first.parent();
+	if(m_bulkEditDepth == 0 || last.parent() != parent) {
+		emit dataChanged(first, last, roles);
+		return;
+	}
+	// Entries whose parent was removed are stale, its pointer may have been reused by a new item
+	auto it = m_pendingChangeIds.find(parent.internalPointer());
+	if(it == m_pendingChangeIds.end() || (!m_pendingChanges[*it].topLevel && !m_pendingChanges[*it].parent.isValid())) {
+		m_pendingChangeIds.insert(parent.internalPointer(), m_pendingChanges.size());
+		m_pendingChanges.append({parent, !parent.isValid(), first, last, first.column(), last.column(), roles});
+		return;
+	}
+	PendingChange& change = m_pendingChanges[*it];
+	if(change.first.isValid() && first.row() < change.first.row()) {
+		change.first = first;
+	}
+	if(change.last.isValid() && last.row() > change.last.row()) {
+		change.last = last;
+	}
+	change.firstColumn = std::min(change.firstColumn, first.column());
+	change.lastColumn = std::max(change.lastColumn, last.column());
+	for(int role : roles) {
+		if(!change.roles.contains(role)) {
+			change.roles.append(role);
+		}
+	}
+}
+
+void HOCRDocument::notifyItemAttributeChanged(const QModelIndex& index, const QString& name, const QString& value) {
+	if(m_bulkEditDepth == 0) {
+		emit itemAttributeChanged(index, name, value);
+		return;
+	}
+	// Only the last value of each attribute is reported
+	QPair<const void*, QString> key = qMakePair(static_cast<const void*>(index.internalPointer()), name);
+	auto it = m_pendingAttributeChangeIds.find(key);
+	if(it != m_pendingAttributeChangeIds.end() && m_pendingAttributeChanges[*it].index == index) {
+		m_pendingAttributeChanges[*it].value = value;
+	} else {
+		m_pendingAttributeChangeIds.insert(key, m_pendingAttributeChanges.size());
+		m_pendingAttributeChanges.append({index, name, value});
+	}
+}
+
+void HOCRDocument::evictPages() {
+	if(m_memoryCap <= 0 || m_evictionBlocked > 0) {
+		return;
+	}
+	QSet<const HOCRPage*> pinned = pinnedPages();
+	QVector<HOCRPage*> candidates;
+	qint64 total = 0;
+	for(HOCRPage* page : m_pages) {
+		if(page->isEvicted()) {
+			continue;
+		}
+		if(page->m_memoryCost == 0) {
+			page->m_memoryCost = page->memoryCost();
+		}
+		total += page->m_memoryCost;
+		if(!page->m_modified && !pinned.contains(page)) {
+			candidates.append(page);
+		}
+	}
+	// Evict the least recently used pages first
+	std::sort(candidates.begin(), candidates.end(), [](const HOCRPage * a, const HOCRPage * b) { return a->m_lastUsed < b->m_lastUsed; });
+	QVector<HOCRPage*> evict;
+	for(int i = 0, n = candidates.size(); i < n && total > m_memoryCap; ++i) {
+		evict.append(candidates[i]);
+		total -= candidates[i]->m_memoryCost;
+	}
+	evictPageChildren(evict);
+}
+
+QSet<const HOCRPage*> HOCRDocument::pinnedPages() const {
+	// Pages referenced by persistent indices (current, selected, expanded items) or pinned explicitly must stay
+	QSet<const HOCRPage*> pinned;
+	for(const QModelIndex& index : persistentIndexList()) {
+		if(index.isValid()) {
+			pinned.insert(itemAtIndex(index)->page());
+		}
+	}
+	for(const HOCRPage* page : m_pages) {
+		if(m_pinnedPages.contains(page->pageId())) {
+			pinned.insert(page);
+		}
+	}
+	return pinned;
+}
+
+int HOCRDocument::evictPageChildren(const QVector<HOCRPage*>& pages) {
+	if(m_evictionBlocked > 0 || QThread::currentThread() != thread()) {
+		// Restored pages count against the memory cap and are evicted again once possible
+		QMetaObject::invokeMethod(&m_evictTimer, "start", Qt::QueuedConnection);
+		return 0;
+	}
+	QSet<const HOCRPage*> pinned = pinnedPages();
+	QList<QPersistentModelIndex> parents;
+	QVector<HOCRPage*> evict;
+	for(HOCRPage* page : pages) {
+		if(!page->isEvicted() && !page->m_modified && !pinned.contains(page)) {
+			parents.append(index(page->index(), 0));
+			evict.append(page);
+		}
+	}
+	if(evict.isEmpty()) {
+		return 0;
+	}
+	// The row counts are unchanged, but all indices and item pointers below the evicted pages become invalid.
+	// Pages with persistent indices are never evicted, so no persistent index needs to be updated.
+	emit layoutAboutToBeChanged(parents);
+	int count = 0;
+	for(HOCRPage* page : evict) {
+		if(page->evictChildren()) {
+			deferSpellCheck(page);
+			++count;
+		}
+	}
+	emit layoutChanged(parents);
+	return count;
+}
+
+void HOCRDocument::insertPages(int beforeIdx, const QVector<HOCRPage*>& pages) {
+	if(pages.isEmpty()) {
+		return;
 	}
-	for(int i = beforeIdx + 1; i < m_pages.size(); ++i) {
+	beginInsertRows(QModelIndex(), beforeIdx, beforeIdx + pages.size() - 1);
+	m_pages.insert(beforeIdx, pages.size(), nullptr);
+	std::copy(pages.begin(), pages.end(), m_pages.begin() + beforeIdx);
+	for(int i = beforeIdx; i < m_pages.size(); ++i) {
 		m_pages[i]->m_index = i;
 	}
+	for(HOCRPage* page : pages) {
+		page->m_lastUsed = ++m_useCounter;
+		indexPage(page);
+		queueSpellCheck(page);
+	}
 	endInsertRows();
-	emit dataChanged(index(0, 0), index(m_pages.size() - 1, 0), {Qt::DisplayRole});
-	return index(beforeIdx, 0);
+	m_evictTimer.start();
+	notifyDataChanged(index(0, 0), index(m_pages.size() - 1, 0), {Qt::DisplayRole});
+}
+
+bool HOCRDocument::readPages(const QByteArray& data, QVector<HOCRPage*>& pages, const QString& sourceBasePath, const QList<Config::Lang>& langSpecs, const std::function<bool(qint64)>& progress) {
+	QVector<HOCRPage*> filePages;
+	// Pages are independent, so if the data can be split at the page boundaries they are parsed concurrently.
+	// If splitting fails (i.e. because of unusual markup), fall back to parsing the data in one go.
+	QVector<QPair<int, int>> ranges = splitPages(data);
+	bool success = ranges.size() > 1 && readPagesConcurrent(data, ranges, filePages, sourceBasePath, langSpecs, progress);
+	if(!success) {
+		qDeleteAll(filePages);
+		filePages.clear();
+		success = readPagesSequential(data, filePages, sourceBasePath, langSpecs, progress);
+	}
+	if(!success) {
+		qDeleteAll(filePages);
+		return false;
+	}
+	pages += filePages;
+	return true;
+}
+
+bool HOCRDocument::seekFirstPage(QXmlStreamReader& reader) {
+	// Seek to html > body > div.ocr_page
+	bool haveBody = false;
+	if(reader.readNextStartElement() && reader.name() == QLatin1String("html")) {
+		while(!haveBody && reader.readNextStartElement()) {
+			haveBody = reader.name() == QLatin1String("body");
+			if(!haveBody) {
+				reader.skipCurrentElement();
+			}
+		}
+	}
+	if(!haveBody) {
+		return false;
+	}
+	while(reader.readNextStartElement()) {
+		if(reader.name() == QLatin1String("div")) {
+			return reader.attributes().value("class") == QLatin1String("ocr_page");
+		}
+		reader.skipCurrentElement();
+	}
+	return false;
+}
+
+QVector<QPair<int, int>> HOCRDocument::splitPages(const QByteArray& data) {
+	// Locate the opening tag of each page div by its class attribute, each page extends up to the next one
+	QVector<QPair<int, int>> ranges;
+	int pos = 0;
+	while((pos = data.indexOf("ocr_page", pos)) != -1) {
+		int tagStart = data.lastIndexOf('<', pos);
+		int quotePos = pos - 1;
+		pos += 8;
+		if(tagStart == -1 || quotePos < 6 || pos >= data.size() || (data[quotePos] != '\'' && data[quotePos] != '"') || data[pos] != data[quotePos]) {
+			continue;
+		}
+		if(data.mid(quotePos - 6, 6) != "class=" || data.mid(tagStart, 4) != "<div" || !std::isspace(data[tagStart + 4]) || data.lastIndexOf('>', pos) > tagStart) {
+			continue;
+		}
+		if(!ranges.isEmpty()) {
+			ranges.last().second = tagStart;
+		}
+		ranges.append(qMakePair(tagStart, -1));
+	}
+	if(ranges.isEmpty()) {
+		return ranges;
+	}
+	int bodyEnd = data.lastIndexOf("</body>");
+	if(bodyEnd < ranges.last().first) {
+		return QVector<QPair<int, int>>();
+	}
+	ranges.last().second = bodyEnd;
+	return ranges;
+}
+
+bool HOCRDocument::readPagesConcurrent(const QByteArray& data, const QVector<QPair<int, int>>& ranges, QVector<HOCRPage*>& pages, const QString& sourceBasePath, const QList<Config::Lang>& langSpecs, const std::function<bool(qint64)>& progress) {
+	// Validate the document structure up to the first page
+	QBuffer buffer;
+	buffer.setData(data);
+	buffer.open(QIODevice::ReadOnly);
+	QXmlStreamReader reader(&buffer);
+	if(!seekFirstPage(reader)) {
+		return false;
+	}
+
+	struct PageJob {
+		int begin;
+		int end;
+		int pageId;
+		HOCRPage* page;
+	};
+	QVector<PageJob> jobs;
+	int firstPageId = m_pageIdCounter.fetchAndAddRelaxed(ranges.size()) + 1;
+	for(int i = 0, n = ranges.size(); i < n; ++i) {
+		jobs.append({ranges[i].first, ranges[i].second, firstPageId + i, nullptr});
+	}
+	QAtomicInteger<qint64> bytesRead(ranges.first().first);
+	QAtomicInt aborted(0);
+	QString defaultLanguage = m_defaultLanguage;
+	std::function<void(PageJob&)> parsePage = [&](PageJob& job) {
+		if(aborted.loadAcquire()) {
+			return;
+		}
+		QBuffer pageBuffer;
+		pageBuffer.setData(QByteArray::fromRawData(data.constData() + job.begin, job.end - job.begin));
+		pageBuffer.open(QIODevice::ReadOnly);
+		QXmlStreamReader pageReader(&pageBuffer);
+		if(!pageReader.readNextStartElement()) {
+			aborted.storeRelease(1);
+			return;
+		}
+		job.page = new HOCRPage(pageReader, job.pageId, defaultLanguage, langSpecs, false, -1);
+		if(pageReader.hasError()) {
+			aborted.storeRelease(1);
+			return;
+		}
+		if(!sourceBasePath.isEmpty()) {
+			job.page->convertSourcePath(sourceBasePath, true);
+		}
+		qint64 total = bytesRead.fetchAndAddRelaxed(job.end - job.begin) + job.end - job.begin;
+		if(progress && !progress(total)) {
+			// Cancelled: keep what was parsed so far, the caller discards it
+			aborted.storeRelease(2);
+		}
+	};
+	QtConcurrent::blockingMap(jobs, parsePage);
+
+	for(const PageJob& job : jobs) {
+		if(job.page) {
+			pages.append(job.page);
+		}
+	}
+	return aborted.loadAcquire() != 1;
+}
+
+bool HOCRDocument::readPagesSequential(const QByteArray& data, QVector<HOCRPage*>& pages, const QString& sourceBasePath, const QList<Config::Lang>& langSpecs, const std::function<bool(qint64)>& progress) {
+	QBuffer buffer;
+	buffer.setData(data);
+	buffer.open(QIODevice::ReadOnly);
+	QXmlStreamReader reader(&buffer);
+	if(!seekFirstPage(reader)) {
+		return false;
+	}
+	// Any subsequent divs are assumed to be pages as well
+	do {
+		if(reader.name() != QLatin1String("div")) {
+			reader.skipCurrentElement();
+			continue;
+		}
+		if(progress && !progress(buffer.pos())) {
+			break;
+		}
+		HOCRPage* page = new HOCRPage(reader, ++m_pageIdCounter, m_defaultLanguage, langSpecs, false, -1);
+		if(!sourceBasePath.isEmpty()) {
+			page->convertSourcePath(sourceBasePath, true);
+		}
+		pages.append(page);
+	} while(reader.readNextStartElement());
+	return !reader.hasError();
 }
 
 QModelIndex HOCRDocument::indexAtItem(const HOCRItem* item) const {
@@ -137,18 +1040,21 @@ bool HOCRDocument::editItemAttribute(const QModelIndex& index, const QString& na
 		return false;
 	}
 
+	quint32 revision = item->page()->revision();
 	item->setAttribute(name, value, attrItemClass);
 	if(name == "title:x_wconf") {
 		QModelIndex colIdx = index.sibling(index.row(), 1);
-		emit dataChanged(colIdx, colIdx, {Qt::DisplayRole});
+		notifyDataChanged(colIdx, colIdx, {Qt::DisplayRole});
 	}
 	if(name == "lang") {
+		queueSpellCheck(item->page());
 		resetMisspelled(index);
 	}
-	emit itemAttributeChanged(index, name, value);
+	notifyItemAttributeChanged(index, name, value);
 	if(name == "title:bbox") {
 		recomputeBBoxes(item->parent());
 	}
+	emitItemEdited(item, revision, ItemEdit::Attribute, value, name, attrItemClass);
 	return true;
 }
 
@@ -157,7 +1063,7 @@ bool HOCRDocument::editItemAttribute(const QModelIndex& index, const QString& na
 QModelIndex HOCRDocument::moveItem(const QModelIndex& itemIndex, const QModelIndex& newParent, int newRow) {
 	HOCRItem* item = mutableItemAtIndex(itemIndex);
 	HOCRItem* parentItem = mutableItemAtIndex(newParent);
-	if(!item || (!parentItem && item->itemClass() != "ocr_page")) {
+	if(!item || (!parentItem && item->itemClassId() != HOCRItem::ItemClass::Page)) {
 		return QModelIndex();
 	}
 	QModelIndex ancestor = newParent;
@@ -184,6 +1090,7 @@ QModelIndex HOCRDocument::moveItem(const QModelIndex& itemIndex, const QModelInd
 }
 
 QModelIndex HOCRDocument::swapItems(const QModelIndex& parent, int firstRow, int secondRow) {
+	BulkEdit bulkEdit(this);
 	moveItem(index(firstRow, 0, parent), parent, secondRow);
 	moveItem(index(secondRow, 0, parent), parent, firstRow);
 	return index(firstRow, 0, parent);
@@ -195,12 +1102,13 @@ QModelIndex HOCRDocument::mergeItems(const QModelIndex& parent, int startRow, in
 	}
 	QModelIndex targetIndex = index(startRow, 0, parent);
 	HOCRItem* targetItem = mutableItemAtIndex(targetIndex);
-	if(!targetItem || targetItem->itemClass() == "ocr_page") {
+	if(!targetItem || targetItem->itemClassId() == HOCRItem::ItemClass::Page) {
 		return QModelIndex();
 	}
 
+	BulkEdit bulkEdit(this);
 	QRect bbox = targetItem->bbox();
-	if(targetItem->itemClass() == "ocrx_word") {
+	if(targetItem->itemClassId() == HOCRItem::ItemClass::Word) {
 		// Merge word items: join text, merge bounding boxes
 		QString text = targetItem->text();
 		beginRemoveRows(parent, startRow + 1, endRow);
@@ -214,7 +1122,7 @@ QModelIndex HOCRDocument::mergeItems(const QModelIndex& parent, int startRow, in
 		endRemoveRows();
 		targetItem->setText(text);
 		for(QModelIndex changedIndex : recheckItemSpelling(targetIndex)) {
-			emit dataChanged(changedIndex, changedIndex, {Qt::DisplayRole, Qt::ForegroundRole});
+			notifyDataChanged(changedIndex, changedIndex, {Qt::DisplayRole, Qt::ForegroundRole});
 		}
 	} else {
 		// Merge other items: merge dom trees and bounding boxes
@@ -237,7 +1145,7 @@ QModelIndex HOCRDocument::mergeItems(const QModelIndex& parent, int startRow, in
 	}
 	QString bboxstr = QString("%1 %2 %3 %4").arg(bbox.left()).arg(bbox.top()).arg(bbox.right()).arg(bbox.bottom());
 	targetItem->setAttribute("title:bbox", bboxstr);
-	emit itemAttributeChanged(targetIndex, "title:bbox", bboxstr);
+	notifyItemAttributeChanged(targetIndex, "title:bbox", bboxstr);
 	return targetIndex;
 }
 
@@ -249,20 +1157,21 @@ QModelIndex HOCRDocument::splitItem(const QModelIndex& itemIndex, int startRow,
 	if(!item) {
 		return QModelIndex();
 	}
-	QString itemClass = item->itemClass();
+	HOCRItem::ItemClass itemClass = item->itemClassId();
 	QDomDocument doc;
 	QDomElement newElement;
-	if(itemClass == "ocr_carea") {
+	if(itemClass == HOCRItem::ItemClass::CArea) {
 		newElement = doc.createElement("div");
-	} else if(itemClass == "ocr_par") {
+	} else if(itemClass == HOCRItem::ItemClass::Par) {
 		newElement = doc.createElement("p");
-	} else if(itemClass == "ocr_line") {
+	} else if(itemClass == HOCRItem::ItemClass::Line) {
 		newElement = doc.createElement("span");
 	} else {
 		return QModelIndex();
 	}
-	newElement.setAttribute("class", itemClass);
+	newElement.setAttribute("class", item->itemClass());
 	newElement.setAttribute("title", HOCRItem::serializeAttrGroup(item->getTitleAttributes()));
+	BulkEdit bulkEdit(this);
 	HOCRItem* newItem = new HOCRItem(newElement, item->page(), item->parent(), item->index() + 1);
 	beginInsertRows(itemIndex.parent(), item->index() + 1, item->index() + 1);
 	insertItem(item->parent(), newItem, item->index() + 1);
@@ -280,7 +1189,7 @@ QModelIndex HOCRDocument::splitItem(const QModelIndex& itemIndex, int startRow,
 
 QModelIndex HOCRDocument::splitItemText(const QModelIndex& itemIndex, int pos) {
 	HOCRItem* item = mutableItemAtIndex(itemIndex);
-	if(!item || item->itemClass() != "ocrx_word") {
+	if(!item || item->itemClassId() != HOCRItem::ItemClass::Word) {
 		return QModelIndex();
 	}
 	// Don't split if it would create empty words
@@ -304,6 +1213,7 @@ QModelIndex HOCRDocument::splitItemText(const QModelIndex& itemIndex, int pos) {
 	attrs["bbox"] = QString("%1 %2 %3 %4").arg(rightBBox.left()).arg(rightBBox.top()).arg(rightBBox.right()).arg(rightBBox.bottom());
 	newElement.setAttribute("title", HOCRItem::serializeAttrGroup(attrs));
 	newElement.setAttribute("lang", item->lang());
+	BulkEdit bulkEdit(this);
 	HOCRItem* newItem = new HOCRItem(newElement, item->page(), item->parent(), item->index() + 1);
 	beginInsertRows(itemIndex.parent(), item->index() + 1, item->index() + 1);
 	insertItem(item->parent(), newItem, item->index() + 1);
@@ -315,7 +1225,7 @@ QModelIndex HOCRDocument::splitItemText(const QModelIndex& itemIndex, int pos) {
 
 QModelIndex HOCRDocument::mergeItemText(const QModelIndex& itemIndex, bool mergeNext) {
 	HOCRItem* item = mutableItemAtIndex(itemIndex);
-	if(!item || item->itemClass() != "ocrx_word") {
+	if(!item || item->itemClassId() != HOCRItem::ItemClass::Word) {
 		return QModelIndex();
 	}
 	if((!mergeNext && item->index() == 0) || (mergeNext && item->index() == item->parent()->children().size() - 1)) {
@@ -325,6 +1235,7 @@ QModelIndex HOCRDocument::mergeItemText(const QModelIndex& itemIndex, bool merge
 	HOCRItem* otherItem = item->parent()->children()[item->index() + offset];
 	QString newText = mergeNext ? item->text() + otherItem->text() : otherItem->text() + item->text();
 	QRect newBbox = item->bbox().united(otherItem->bbox());
+	BulkEdit bulkEdit(this);
 	setData(itemIndex, newText, Qt::EditRole);
 	editItemAttribute(itemIndex, "title:bbox", QString("%1 %2 %3 %4").arg(newBbox.left()).arg(newBbox.top()).arg(newBbox.right()).arg(newBbox.bottom()));
 	beginRemoveRows(itemIndex.parent(), itemIndex.row() + offset, itemIndex.row() + offset);
@@ -360,19 +1271,93 @@ bool HOCRDocument::removeItem(const QModelIndex& index) {
 	return true;
 }
 
-QModelIndex HOCRDocument::nextIndex(const QModelIndex& current) const {
-	QModelIndex idx = current;
-	// If the current index is invalid return first index
-	if(!idx.isValid()) {
-		return index(0, 0);
-	}
-	// If item has children, return first child
-	if(rowCount(idx) > 0) {
-		return index(0, 0, idx);
+int HOCRDocument::editWordTexts(const std::function<bool(QString&)>& edit) {
+	BulkEdit bulkEdit(this);
+	int count = 0;
+	for(int i = 0, n = m_pages.size(); i < n; ++i) {
+		// Evicted pages without matches are evicted again right away
+		bool evicted = m_pages[i]->isEvicted();
+		int pageCount = editWordTexts(index(i, 0), edit);
+		if(evicted && pageCount == 0) {
+			evictPageChildren({m_pages[i]});
+		}
+		count += pageCount;
 	}
-	// Return next possible sibling
-	QModelIndex next = idx.sibling(idx.row() + 1, 0);
-	while(idx.isValid() && !next.isValid()) {
+	return count;
+}
+
+int HOCRDocument::editWordTexts(const QModelIndex& parent, const std::function<bool(QString&)>& edit) {
+	HOCRItem* item = mutableItemAtIndex(parent);
+	int count = 0;
+	int firstRow = -1;
+	int lastRow = -1;
+	for(int i = 0, n = item->children().size(); i < n; ++i) {
+		HOCRItem* child = item->children()[i];
+		if(child->itemClassId() != HOCRItem::ItemClass::Word) {
+			count += editWordTexts(index(i, 0, parent), edit);
+			continue;
+		}
+		QString text = child->text();
+		if(!edit(text) || text == child->text()) {
+			continue;
+		}
+		++count;
+		quint32 revision = child->page()->revision();
+		child->setText(text);
+		emitItemEdited(child, revision, ItemEdit::Text, text);
+		firstRow = firstRow < 0 ? i : firstRow;
+		lastRow = i;
+		for(const QModelIndex& changedIndex : recheckItemSpelling(index(i, 0, parent))) {
+			// Hyphenated words may change the state of a word on a neighbouring line
+			if(changedIndex.parent() == parent) {
+				firstRow = std::min(firstRow, changedIndex.row());
+				lastRow = std::max(lastRow, changedIndex.row());
+			} else {
+				notifyDataChanged(changedIndex, changedIndex, {Qt::ForegroundRole});
+			}
+		}
+	}
+	if(firstRow >= 0) {
+		notifyDataChanged(index(firstRow, 0, parent), index(lastRow, 0, parent), {Qt::DisplayRole, Qt::ForegroundRole});
+	}
+	return count;
+}
+
+int HOCRDocument::replaceWordTexts(const QString& search, const QString& replace, Qt::CaseSensitivity cs) {
+	if(search.isEmpty()) {
+		return 0;
+	}
+	BulkEdit bulkEdit(this);
+	int count = 0;
+	for(int i = 0, n = m_pages.size(); i < n; ++i) {
+		// Pages whose text index does not contain the search string are skipped
+		if(m_pages[i]->findWord(search, cs, 0, std::numeric_limits<int>::max(), false) < 0) {
+			continue;
+		}
+		count += editWordTexts(index(i, 0), [&](QString& text) {
+			if(!text.contains(search, cs)) {
+				return false;
+			}
+			text.replace(search, replace, cs);
+			return true;
+		});
+	}
+	return count;
+}
+
+QModelIndex HOCRDocument::nextIndex(const QModelIndex& current) const {
+	QModelIndex idx = current;
+	// If the current index is invalid return first index
+	if(!idx.isValid()) {
+		return index(0, 0);
+	}
+	// If item has children, return first child
+	if(rowCount(idx) > 0) {
+		return index(0, 0, idx);
+	}
+	// Return next possible sibling
+	QModelIndex next = idx.sibling(idx.row() + 1, 0);
+	while(idx.isValid() && !next.isValid()) {
 		idx = idx.parent();
 		next = idx.sibling(idx.row() + 1, 0);
 	}
@@ -410,10 +1395,29 @@ QModelIndex HOCRDocument::prevOrNextIndex(bool next, const QModelIndex& current,
 	if(!start.isValid()) {
 		start = index(0, 0);
 	}
+	HOCRItem::ItemClass itemClass = HOCRItem::itemClassFromName(ocrClass);
+	if(itemClass == HOCRItem::ItemClass::Word && (misspelled || lowconf)) {
+		// Binary search in the sorted per-page lists of flagged words
+		QModelIndex result = searchWords(current, !next, [&](const HOCRPage* page, int begin, int end) {
+			QVector<int> words = misspelled ? misspelledWords(page) : page->textIndex().lowConfidence;
+			if(misspelled && lowconf) {
+				const QVector<int>& lowConfidence = page->textIndex().lowConfidence;
+				QVector<int> both;
+				std::set_intersection(words.begin(), words.end(), lowConfidence.begin(), lowConfidence.end(), std::back_inserter(both));
+				words = both;
+			}
+			auto it = std::lower_bound(words.cbegin(), words.cend(), next ? begin : end);
+			if(next) {
+				return it != words.cend() && *it < end ? *it : -1;
+			}
+			return it != words.cbegin() && *(it - 1) >= begin ? *(it - 1) : -1;
+		});
+		return result.isValid() ? result : start;
+	}
 	QModelIndex curr = next ? nextIndex(start) : prevIndex(start);
 	while(curr != start) {
 		const HOCRItem* item = itemAtIndex(curr);
-		if(item && item->itemClass() == ocrClass && (!misspelled || indexIsMisspelledWord(curr)) && (!lowconf || item->getTitleAttributes()["x_wconf"].toInt() < 90)) {
+		if(item && item->itemClassId() == itemClass && (itemClass != HOCRItem::ItemClass::Other || item->itemClass() == ocrClass) && (!misspelled || indexIsMisspelledWord(curr)) && (!lowconf || item->wordConfidence() < s_lowConfidence)) {
 			break;
 		}
 		curr = next ? nextIndex(curr) : prevIndex(curr);
@@ -421,6 +1425,75 @@ QModelIndex HOCRDocument::prevOrNextIndex(bool next, const QModelIndex& current,
 	return curr;
 }
 
+QModelIndex HOCRDocument::searchWords(const QModelIndex& from, bool backwards, const std::function<int(const HOCRPage*, int, int)>& pageSearch) const {
+	if(m_pages.isEmpty()) {
+		return QModelIndex();
+	}
+	const int all = std::numeric_limits<int>::max();
+	const HOCRItem* item = itemAtIndex(from);
+	int startPage = item ? item->page()->index() : (backwards ? m_pages.size() - 1 : 0);
+	// The words of the start page are split in those before from and those after from
+	int split = !item ? (backwards ? all : 0) : item == item->page() ? 0 : item->page()->wordsBefore(item);
+	int skip = item && item->itemClassId() == HOCRItem::ItemClass::Word ? 1 : 0;
+	auto search = [&](int page, int begin, int end) {
+		int word = pageSearch(m_pages[page], begin, end);
+		return word >= 0 ? indexAtItem(m_pages[page]->word(word)) : QModelIndex();
+	};
+	QModelIndex result = backwards ? search(startPage, 0, split) : search(startPage, split + skip, all);
+	for(int i = 1, n = m_pages.size(); i < n && !result.isValid(); ++i) {
+		result = search(backwards ? (startPage - i + n) % n : (startPage + i) % n, 0, all);
+	}
+	if(!result.isValid()) {
+		result = backwards ? search(startPage, split + skip, all) : search(startPage, 0, split);
+	}
+	return result;
+}
+
+QModelIndex HOCRDocument::findWord(const QModelIndex& from, const QString& str, Qt::CaseSensitivity cs, bool backwards) const {
+	if(str.isEmpty()) {
+		return QModelIndex();
+	}
+	return searchWords(from, backwards, [&](const HOCRPage* page, int begin, int end) {
+		return page->findWord(str, cs, begin, end, backwards);
+	});
+}
+
+const QVector<int>& HOCRDocument::misspelledWords(const HOCRPage* page) const {
+	// Words are only checked in the background, pages which are still queued (or deferred until they are
+	// restored) are skipped instead of checking them here
+	static const QVector<int> none;
+	if(page->m_spellCheckPending) {
+		return none;
+	}
+	if(!page->m_misspelledWords) {
+		QVector<int>* words = new QVector<int>;
+		int n = 0;
+		auto visitor = [&](const HOCRItem* item) {
+			if(item->itemClassId() == HOCRItem::ItemClass::Word) {
+				if(item->isMisspelled() == 1) {
+					words->append(n);
+				}
+				++n;
+			}
+			return true;
+		};
+		// Evicted pages are read from a copy, which keeps them evicted
+		QVector<HOCRItem*> children;
+		if(page->detachEvictedChildren(children)) {
+			for(const HOCRItem* child : children) {
+				if(visitor(child)) {
+					visitItems(child, visitor);
+				}
+			}
+			qDeleteAll(children);
+		} else {
+			visitItems(page, visitor);
+		}
+		page->m_misspelledWords.reset(words);
+	}
+	return *page->m_misspelledWords;
+}
+
 bool HOCRDocument::indexIsMisspelledWord(const QModelIndex& index) const {
 	const HOCRItem* item = itemAtIndex(index);
 	if(item->isMisspelled() == -1) {
@@ -431,21 +1504,21 @@ bool HOCRDocument::indexIsMisspelledWord(const QModelIndex& index) const {
 
 QList<QModelIndex> HOCRDocument::recheckItemSpelling(const QModelIndex& index) const {
 	HOCRItem* item = mutableItemAtIndex(index);
-	if(item->itemClass() != "ocrx_word") { return {}; }
+	if(item->itemClassId() != HOCRItem::ItemClass::Word) { return {}; }
 
 	QString prefix, suffix, trimmed = HOCRItem::trimmedWord(item->text(), &prefix, &suffix);
 	if(trimmed.isEmpty()) {
 		item->setMisspelled(false);
 		return {index};
 	}
-	QString lang = item->spellingLang();
-	if(lang.isEmpty() || (m_spell->getLanguage() != lang && !(m_spell->setLanguage(lang)))) {
+	int lang = item->langId();
+	if(lang == 0) {
 		item->setMisspelled(false);
 		return {index};
 	}
 
 	// check word, including (if requested) setting suggestions; handle hyphenated phrases correctly
-	if(m_spell->checkSpelling(trimmed)) {
+	if(checkSpelling(lang, trimmed)) {
 		item->setMisspelled(false);
 		return {index};
 	}
@@ -464,12 +1537,12 @@ QList<QModelIndex> HOCRDocument::recheckItemSpelling(const QModelIndex& index) c
 		HOCRItem* prevLine = paragraphLines.at(lineIdx - 1);
 		if(!prevLine || prevLine->children().isEmpty()) { return {index}; }
 		HOCRItem* prevWord = prevLine->children().back();
-		if(!prevWord || prevWord->itemClass() != "ocrx_word") { return {index}; }
+		if(!prevWord || prevWord->itemClassId() != HOCRItem::ItemClass::Word) { return {index}; }
 		QString prevText = prevWord->text();
 		if(!prevText.endsWith("-")) { return {index}; }
 
 		// don't bother with (reassembled) suggestions for broken words since we can't re-break them
-		bool valid = m_spell->checkSpelling(HOCRItem::trimmedWord(prevText) + trimmed);
+		bool valid = checkSpelling(lang, HOCRItem::trimmedWord(prevText) + trimmed);
 		item->setMisspelled(!valid);
 		prevWord->setMisspelled(!valid);
 		return {index, indexAtItem(prevWord)};
@@ -477,9 +1550,9 @@ QList<QModelIndex> HOCRDocument::recheckItemSpelling(const QModelIndex& index) c
 		HOCRItem* nextLine = paragraphLines.at(lineIdx + 1);
 		if(!nextLine || nextLine->children().isEmpty()) { return {index}; }
 		HOCRItem* nextWord = nextLine->children().front();
-		if(!nextWord || nextWord->itemClass() != "ocrx_word") { return {index}; }
+		if(!nextWord || nextWord->itemClassId() != HOCRItem::ItemClass::Word) { return {index}; }
 
-		bool valid = m_spell->checkSpelling(trimmed + HOCRItem::trimmedWord(nextWord->text()));
+		bool valid = checkSpelling(lang, trimmed + HOCRItem::trimmedWord(nextWord->text()));
 		item->setMisspelled(!valid);
 		nextWord->setMisspelled(!valid);
 		return {index, indexAtItem(nextWord)};
@@ -487,16 +1560,214 @@ QList<QModelIndex> HOCRDocument::recheckItemSpelling(const QModelIndex& index) c
 	return {index};
 }
 
+bool HOCRDocument::checkSpelling(int langId, const QString& word) const {
+	QPair<int, QString> key(langId, word);
+	{
+		QMutexLocker locker(&m_spellCacheMutex);
+		auto it = m_spellCache.constFind(key);
+		if(it != m_spellCache.constEnd()) {
+			return it.value();
+		}
+	}
+	// Treat words as valid if no dictionary is available for the language
+	QString lang = HOCRLanguage::fromId(langId)->lang();
+	bool valid;
+	{
+		QMutexLocker locker(&m_dictMutex);
+		valid = (m_spell->getLanguage() != lang && !m_spell->setLanguage(lang)) || m_spell->checkSpelling(word);
+	}
+	QMutexLocker locker(&m_spellCacheMutex);
+	m_spellCache.insert(key, valid);
+	return valid;
+}
+
+void HOCRDocument::ignoreSpelling(const QString& word) {
+	{
+		// Invalidates the results of a running background check, the page is then checked again
+		QMutexLocker locker(&m_spellCacheMutex);
+		m_spellGeneration.ref();
+		for(auto it = m_spellCache.begin(); it != m_spellCache.end();) {
+			if(it.key().second == word) {
+				it = m_spellCache.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+	QMutexLocker locker(&m_dictMutex);
+	m_bgSpell->ignoreWord(word);
+}
+
+void HOCRDocument::queueSpellCheck(HOCRPage* page) {
+	if(!page->m_spellCheckPending) {
+		page->m_spellCheckPending = true;
+		m_spellQueue.append(page);
+	}
+	startSpellCheck();
+}
+
+void HOCRDocument::unqueueSpellCheck(HOCRPage* page) {
+	m_spellQueue.removeOne(page);
+	m_spellDeferred.remove(page);
+	if(m_spellPage == page) {
+		m_spellPage = nullptr;
+	}
+	page->m_spellCheckPending = false;
+}
+
+void HOCRDocument::deferSpellCheck(HOCRPage* page) {
+	// The page remains pending, the words of an interrupted job are mostly cached by the time it is restored
+	if(page->m_spellCheckPending) {
+		m_spellQueue.removeOne(page);
+		if(m_spellPage == page) {
+			m_spellPage = nullptr;
+		}
+		m_spellDeferred.insert(page);
+	}
+}
+
+void HOCRDocument::resumeSpellCheck(HOCRPage* page) {
+	if(m_spellDeferred.remove(page)) {
+		m_spellQueue.append(page);
+		startSpellCheck();
+	}
+}
+
+void HOCRDocument::startSpellCheck() {
+	// Evicted pages (including the lazily loaded pages of project files) are checked once restored
+	while(!m_spellQueue.isEmpty() && m_spellQueue.first()->isEvicted()) {
+		m_spellDeferred.insert(m_spellQueue.takeFirst());
+	}
+	if(m_spellPage || m_spellQueue.isEmpty()) {
+		return;
+	}
+	m_spellPage = m_spellQueue.takeFirst();
+	QSet<QPair<int, QString>> words;
+	collectSpellCheckWords(m_spellPage, words);
+	int pageId = m_spellPage->pageId();
+	int generation = m_spellGeneration.loadAcquire();
+	QtConcurrent::run(&m_spellPool, [this, words, pageId, generation] {
+		// Group by language to avoid switching dictionaries for every word
+		QList<QPair<int, QString>> sorted = words.values();
+		std::sort(sorted.begin(), sorted.end());
+		int curLang = 0;
+		bool haveDict = false;
+		for(const QPair<int, QString>& key : sorted) {
+			{
+				QMutexLocker locker(&m_spellCacheMutex);
+				if(m_spellGeneration.loadAcquire() != generation) {
+					break;
+				}
+				if(m_spellCache.contains(key)) {
+					continue;
+				}
+			}
+			bool valid = true;
+			{
+				// Locked per word, so that the GUI thread never waits for more than a single lookup
+				QMutexLocker locker(&m_dictMutex);
+				if(key.first != curLang) {
+					curLang = key.first;
+					QString lang = HOCRLanguage::fromId(curLang)->lang();
+					haveDict = m_bgSpell->getLanguage() == lang || m_bgSpell->setLanguage(lang);
+				}
+				// Treat words as valid if no dictionary is available for the language
+				valid = !haveDict || m_bgSpell->checkSpelling(key.second);
+			}
+			QMutexLocker locker(&m_spellCacheMutex);
+			// Discard the result if the cache was invalidated in the meantime
+			if(m_spellGeneration.loadAcquire() == generation) {
+				m_spellCache.insert(key, valid);
+			}
+		}
+		emit spellCheckDone(pageId, generation);
+	});
+}
+
+void HOCRDocument::spellCheckFinished(int pageId, int generation) {
+	// Results of a job whose page was unqueued, cleared or replaced in the meantime are dropped
+	if(!m_spellPage || m_spellPage->pageId() != pageId) {
+		startSpellCheck();
+		return;
+	}
+	HOCRPage* page = m_spellPage;
+	m_spellPage = nullptr;
+	if(page && generation != m_spellGeneration.loadAcquire()) {
+		m_spellQueue.prepend(page);
+	} else if(page) {
+		page->m_spellCheckPending = false;
+		if(!page->isEvicted()) {
+			applySpellCheck(index(page->index(), 0));
+		}
+	}
+	startSpellCheck();
+}
+
+void HOCRDocument::collectSpellCheckWords(const HOCRItem* item, QSet<QPair<int, QString>>& words) const {
+	if(item->itemClassId() == HOCRItem::ItemClass::Word) {
+		QString trimmed = HOCRItem::trimmedWord(item->text());
+		int lang = item->langId();
+		if(item->isMisspelled() == -1 && !trimmed.isEmpty() && lang != 0) {
+			words.insert(qMakePair(lang, trimmed));
+		}
+		return;
+	}
+	// Words hyphenated across lines are checked joined, see recheckItemSpelling
+	const HOCRItem* parent = item->parent();
+	if(item->itemClassId() == HOCRItem::ItemClass::Line && parent && item->index() + 1 < parent->children().size() && !item->children().isEmpty()) {
+		const HOCRItem* lastWord = item->children().back();
+		const HOCRItem* nextWord = parent->children()[item->index() + 1]->children().value(0);
+		if(nextWord && lastWord->itemClassId() == HOCRItem::ItemClass::Word && nextWord->itemClassId() == HOCRItem::ItemClass::Word && lastWord->text().endsWith("-")) {
+			QString joined = HOCRItem::trimmedWord(lastWord->text()) + HOCRItem::trimmedWord(nextWord->text());
+			for(int lang : {lastWord->langId(), nextWord->langId()}) {
+				if(lang != 0) {
+					words.insert(qMakePair(lang, joined));
+				}
+			}
+		}
+	}
+	for(const HOCRItem* child : item->children()) {
+		collectSpellCheckWords(child, words);
+	}
+}
+
+void HOCRDocument::applySpellCheck(const QModelIndex& index) {
+	// The words were just checked in the background, so recheckItemSpelling is served from the cache
+	const HOCRItem* item = itemAtIndex(index);
+	bool haveWords = false;
+	for(int i = 0, n = item->children().size(); i < n; ++i) {
+		const HOCRItem* child = item->children()[i];
+		if(child->itemClassId() != HOCRItem::ItemClass::Word) {
+			applySpellCheck(this->index(i, 0, index));
+			continue;
+		}
+		haveWords = true;
+		if(child->isMisspelled() == -1) {
+			for(const QModelIndex& changedIndex : recheckItemSpelling(this->index(i, 0, index))) {
+				// Hyphenated words may change the state of a word on a neighbouring line
+				if(changedIndex.parent() != index) {
+					emit dataChanged(changedIndex, changedIndex, {Qt::ForegroundRole});
+				}
+			}
+		}
+	}
+	// One notification for all words of the item
+	if(haveWords) {
+		emit dataChanged(this->index(0, 0, index), this->index(item->children().size() - 1, 0, index), {Qt::ForegroundRole});
+	}
+}
+
 bool HOCRDocument::getItemSpellingSuggestions(const QModelIndex& index, QString& trimmedWord, QStringList& suggestions, int limit) const {
 	const HOCRItem* item = itemAtIndex(index);
-	if(item->itemClass() != "ocrx_word") { return true; }
+	if(item->itemClassId() != HOCRItem::ItemClass::Word) { return true; }
 
 	QString prefix, suffix;
 	trimmedWord = HOCRItem::trimmedWord(item->text(), &prefix, &suffix);
 	if(trimmedWord.isEmpty()) {
 		return true;
 	}
-	QString lang = item->spellingLang();
+	QString lang = item->lang();
+	QMutexLocker locker(&m_dictMutex);
 	if(m_spell->getLanguage() != lang && !(m_spell->setLanguage(lang))) {
 		return true;
 	}
@@ -509,22 +1780,18 @@ bool HOCRDocument::getItemSpellingSuggestions(const QModelIndex& index, QString&
 }
 
 bool HOCRDocument::referencesSource(const QString& filename) const {
-	for(const HOCRPage* page : m_pages) {
-		if(page->sourceFile() == filename) {
-			return true;
-		}
-	}
-	return false;
+	return m_sourceRefCount.contains(filename);
 }
 
 QModelIndex HOCRDocument::searchPage(const QString& filename, int pageNr) const {
-	for(int iPage = 0, nPages = m_pages.size(); iPage < nPages; ++iPage) {
-		const HOCRPage* page = m_pages[iPage];
-		if(page->sourceFile() == filename && page->pageNr() == pageNr) {
-			return index(iPage, 0);
+	// If a source page was recognized multiple times, return the first occurrence
+	const HOCRPage* result = nullptr;
+	for(const HOCRPage* page : m_sourcePages.values(qMakePair(filename, pageNr))) {
+		if(!result || page->index() < result->index()) {
+			result = page;
 		}
 	}
-	return QModelIndex();
+	return result ? index(result->index(), 0) : QModelIndex();
 }
 
 QModelIndex HOCRDocument::searchAtCanvasPos(const QModelIndex& pageIndex, const QPoint& pos) const {
@@ -533,26 +1800,30 @@ QModelIndex HOCRDocument::searchAtCanvasPos(const QModelIndex& pageIndex, const
 		return QModelIndex();
 	}
 	const HOCRItem* item = itemAtIndex(idx);
+	QVector<HOCRItem*> candidates = item->page()->itemsAt(pos);
+	// At each level, descend into the first child containing pos
 	while(true) {
-		int iChild = 0, nChildren = item->children().size();
-		for(; iChild < nChildren; ++iChild) {
-			const HOCRItem* childItem = item->children()[iChild];
-			if(childItem->bbox().contains(pos)) {
-				item = childItem;
-				idx = index(iChild, 0, idx);
-				break;
+		const HOCRItem* next = nullptr;
+		for(const HOCRItem* candidate : candidates) {
+			if(candidate->parent() == item && (!next || candidate->index() < next->index())) {
+				next = candidate;
 			}
 		}
-		if(iChild == nChildren) {
+		if(!next) {
 			break;
 		}
+		item = next;
+		idx = index(item->index(), 0, idx);
 	}
 	return idx;
 }
 
 void HOCRDocument::convertSourcePaths(const QString& basepath, bool absolute) {
+	m_sourcePages.clear();
+	m_sourceRefCount.clear();
 	for(HOCRPage* page : m_pages) {
 		page->convertSourcePath(basepath, absolute);
+		indexPage(page);
 	}
 }
 
@@ -579,10 +1850,12 @@ QVariant HOCRDocument::data(const QModelIndex& index, int role) const {
 				enabled = parent->isEnabled();
 				parent = parent->parent();
 			}
+			// Don't check synchronously while the page is queued for background checking
+			bool misspelled = item->isMisspelled() == -1 && item->page()->m_spellCheckPending ? false : indexIsMisspelledWord(index);
 			if(enabled) {
-				return indexIsMisspelledWord(index) ? QVariant(QColor(Qt::red)) : QVariant();
+				return misspelled ? QVariant(QColor(Qt::red)) : QVariant();
 			} else {
-				return indexIsMisspelledWord(index) ? QVariant(QColor(208, 80, 82)) : QVariant(QColor(Qt::gray));
+				return misspelled ? QVariant(QColor(208, 80, 82)) : QVariant(QColor(Qt::gray));
 			}
 		}
 		case Qt::CheckStateRole:
@@ -591,8 +1864,8 @@ QVariant HOCRDocument::data(const QModelIndex& index, int role) const {
 			break;
 		}
 	} else if(index.column() == 1) {
-		if(role == Qt::DisplayRole && item->itemClass() == "ocrx_word") {
-			return item->getTitleAttributes()["x_wconf"];
+		if(role == Qt::DisplayRole && item->itemClassId() == HOCRItem::ItemClass::Word) {
+			return item->titleAttribute("x_wconf");
 		}
 	}
 	return QVariant();
@@ -604,26 +1877,60 @@ bool HOCRDocument::setData(const QModelIndex& index, const QVariant& value, int
 	}
 
 	HOCRItem* item = mutableItemAtIndex(index);
-	if(role == Qt::EditRole && item->itemClass() == "ocrx_word") {
+	quint32 revision = item->page()->revision();
+	if(role == Qt::EditRole && item->itemClassId() == HOCRItem::ItemClass::Word) {
 		item->setText(value.toString());
+		emitItemEdited(item, revision, ItemEdit::Text, item->text());
 		for(QModelIndex changedIndex : recheckItemSpelling(index)) {
-			emit dataChanged(changedIndex, changedIndex, {Qt::DisplayRole, Qt::ForegroundRole});
+			notifyDataChanged(changedIndex, changedIndex, {Qt::DisplayRole, Qt::ForegroundRole});
 		}
 
 		return true;
 	} else if(role == Qt::CheckStateRole) {
 		item->setEnabled(value == Qt::Checked);
+		emitItemEdited(item, revision, ItemEdit::Enabled, item->isEnabled() ? "1" : "0");
 		// Get leaf
 		QModelIndex leaf = index;
 		while(hasChildren(leaf)) {
 			leaf = this->index(rowCount(leaf) - 1, 0, leaf);
 		}
-		emit dataChanged(index, leaf, {Qt::CheckStateRole});
+		notifyDataChanged(index, leaf, {Qt::CheckStateRole});
 		return true;
 	}
 	return false;
 }
 
+void HOCRDocument::emitItemEdited(const HOCRItem* item, quint32 revision, ItemEdit::Type type, const QString& value, const QString& name, const QString& attrItemClass) {
+	ItemEdit edit{type, {}, name, value, attrItemClass};
+	for(; item->parent(); item = item->parent()) {
+		edit.path.prepend(item->index());
+	}
+	emit itemEdited(item->page(), revision, edit);
+}
+
+bool HOCRDocument::applyItemEdit(HOCRPage* page, const ItemEdit& edit) {
+	HOCRItem* item = page;
+	for(int row : edit.path) {
+		item = item->children().value(row);
+		if(!item) {
+			return false;
+		}
+	}
+	if(edit.type == ItemEdit::Text && item->itemClassId() == HOCRItem::ItemClass::Word) {
+		item->setText(edit.value);
+	} else if(edit.type == ItemEdit::Enabled) {
+		item->setEnabled(edit.value == "1");
+	} else if(edit.type == ItemEdit::Attribute) {
+		item->setAttribute(edit.name, edit.value, edit.attrItemClass);
+		if(edit.name == "title:bbox") {
+			recomputeBBoxes(item->parent());
+		}
+	} else {
+		return false;
+	}
+	return true;
+}
+
 void HOCRDocument::recomputeBBoxes(HOCRItem* item) {
 	// Update parent bboxes (except page)
 	while(item && item->parent()) {
@@ -643,7 +1950,7 @@ Qt::ItemFlags HOCRDocument::flags(const QModelIndex& index) const {
 	}
 
 	HOCRItem* item = mutableItemAtIndex(index);
-	return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable | (item->itemClass() == "ocrx_word" && index.column() == 0 ? Qt::ItemIsEditable : Qt::NoItemFlags);
+	return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable | (item->itemClassId() == HOCRItem::ItemClass::Word && index.column() == 0 ? Qt::ItemIsEditable : Qt::NoItemFlags);
 }
 
 QModelIndex HOCRDocument::index(int row, int column, const QModelIndex& parent) const {
@@ -656,7 +1963,21 @@ QModelIndex HOCRDocument::index(int row, int column, const QModelIndex& parent)
 		childItem = m_pages.value(row);
 	} else {
 		HOCRItem* parentItem = mutableItemAtIndex(parent);
-		childItem = parentItem->children().value(row);
+		if(parentItem->itemClassId() == HOCRItem::ItemClass::Page) {
+			HOCRPage* page = static_cast<HOCRPage*>(parentItem);
+			page->m_lastUsed = ++m_useCounter;
+			// Indices into an evicted page restore it, which leaves the row counts unchanged. Restored pages
+			// count against the memory cap.
+			if(page->isEvicted()) {
+				page->restoreEvictedChildren();
+				m_evictTimer.start();
+			}
+			// Only the queue is modified, which does not affect the model
+			if(page->m_spellCheckPending) {
+				const_cast<HOCRDocument*>(this)->resumeSpellCheck(page);
+			}
+		}
+		childItem = parentItem->m_childItems.value(row);
 	}
 	return childItem ? createIndex(row, column, childItem) : QModelIndex();
 }
@@ -678,7 +1999,7 @@ int HOCRDocument::rowCount(const QModelIndex& parent) const {
 	if (parent.column() > 0) {
 		return 0;
 	}
-	return !parent.isValid() ? m_pages.size() : itemAtIndex(parent)->children().size();
+	return !parent.isValid() ? m_pages.size() : itemAtIndex(parent)->childCount();
 }
 
 int HOCRDocument::columnCount(const QModelIndex& /*parent*/) const {
@@ -686,47 +2007,44 @@ int HOCRDocument::columnCount(const QModelIndex& /*parent*/) const {
 }
 
 QString HOCRDocument::displayRoleForItem(const HOCRItem* item) const {
-	QString itemClass = item->itemClass();
-	if(itemClass == "ocr_page") {
+	HOCRItem::ItemClass itemClass = item->itemClassId();
+	if(itemClass == HOCRItem::ItemClass::Page) {
 		const HOCRPage* page = static_cast<const HOCRPage*>(item);
-		return QString("%1 (%2 %3/%4)").arg(page->title()).arg(_("Page")).arg(item->index() + 1).arg(m_pages.size());
-	} else if(itemClass == "ocr_carea") {
-		return _("Text block");
-	} else if(itemClass == "ocr_par") {
-		return _("Paragraph");
-	} else if(itemClass == "ocr_line") {
-		return _("Textline");
-	} else if(itemClass == "ocrx_word") {
+		return QString("%1 (%2 %3/%4)").arg(page->title()).arg(m_classLabels[int(itemClass)]).arg(item->index() + 1).arg(m_pages.size());
+	} else if(itemClass == HOCRItem::ItemClass::Word) {
 		return item->text();
-	} else if(itemClass == "ocr_graphic") {
-		return _("Graphic");
 	}
-	return "";
+	return m_classLabels[int(itemClass)];
 }
 
 QIcon HOCRDocument::decorationRoleForItem(const HOCRItem* item) const {
-	QString itemClass = item->itemClass();
-	if(itemClass == "ocr_page") {
-		return QIcon(":/icons/item_page");
-	} else if(itemClass == "ocr_carea") {
-		return QIcon(":/icons/item_block");
-	} else if(itemClass == "ocr_par") {
-		return QIcon(":/icons/item_par");
-	} else if(itemClass == "ocr_line") {
-		return QIcon(":/icons/item_line");
-	} else if(itemClass == "ocrx_word") {
-		return QIcon(":/icons/item_word");
-	} else if(itemClass == "ocr_graphic") {
-		return QIcon(":/icons/item_halftone");
-	}
-	return QIcon();
+	return m_classIcons[int(item->itemClassId())];
 }
 
 QString HOCRDocument::tooltipRoleForItem(const HOCRItem* item) const {
-	QString itemClass = item->itemClass();
-	if(itemClass == "ocr_page") {
+	HOCRItem::ItemClass itemClass = item->itemClassId();
+	if(itemClass == HOCRItem::ItemClass::Page) {
 		const HOCRPage* page = static_cast<const HOCRPage*>(item);
-		return QString("%1 (%2 %3/%4)").arg(page->title()).arg(_("Page")).arg(item->index() + 1).arg(m_pages.size());
+		QString tooltip = QString("%1 (%2 %3/%4)").arg(page->title()).arg(m_classLabels[int(itemClass)]).arg(item->index() + 1).arg(m_pages.size());
+		// Tooltips neither restore evicted pages nor check spelling, only what is known already is shown
+		if(page->m_textIndex || !page->isEvicted()) {
+			tooltip += "\n" + _("Low confidence words: %1").arg(page->textIndex().lowConfidence.size());
+		}
+		// Misspelled words are only counted once the background spell check of the page is done
+		int misspelled = -1;
+		if(!page->m_spellCheckPending && page->m_misspelledWords) {
+			misspelled = page->m_misspelledWords->size();
+		} else if(!page->m_spellCheckPending && !page->isEvicted()) {
+			misspelled = 0;
+			visitItems(page, [&misspelled](const HOCRItem* item) {
+				misspelled += item->itemClassId() == HOCRItem::ItemClass::Word && item->isMisspelled() == 1;
+				return true;
+			});
+		}
+		if(misspelled >= 0) {
+			tooltip += "\n" + _("Misspelled words: %1").arg(misspelled);
+		}
+		return tooltip;
 	}
 	return QString();
 }
@@ -740,7 +2058,9 @@ void HOCRDocument::insertItem(HOCRItem* parent, HOCRItem* item, int i) {
 		for(int n = m_pages.size(); i < n; ++i) {
 			m_pages[i]->m_index = i;
 		}
-		emit dataChanged(index(page->index(), 0), index(m_pages.size() - 1, 0), {Qt::DisplayRole});
+		indexPage(page);
+		queueSpellCheck(page);
+		notifyDataChanged(index(page->index(), 0), index(m_pages.size() - 1, 0), {Qt::DisplayRole});
 	}
 }
 
@@ -758,19 +2078,217 @@ void HOCRDocument::takeItem(HOCRItem* item) {
 		for(int n = m_pages.size(); i < n; ++i) {
 			m_pages[i]->m_index = i;
 		}
-		emit dataChanged(index(page->index(), 0), index(m_pages.size() - 1, 0), {Qt::DisplayRole});
+		unindexPage(page);
+		unqueueSpellCheck(page);
+		notifyDataChanged(index(page->index(), 0), index(m_pages.size() - 1, 0), {Qt::DisplayRole});
+	}
+}
+
+void HOCRDocument::indexPage(HOCRPage* page) {
+	m_sourcePages.insert(qMakePair(page->sourceFile(), page->pageNr()), page);
+	++m_sourceRefCount[page->sourceFile()];
+}
+
+void HOCRDocument::unindexPage(HOCRPage* page) {
+	m_sourcePages.remove(qMakePair(page->sourceFile(), page->pageNr()), page);
+	auto it = m_sourceRefCount.find(page->sourceFile());
+	if(it != m_sourceRefCount.end() && --it.value() == 0) {
+		m_sourceRefCount.erase(it);
 	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Table which is looked up by all parser threads but rarely grows, lookups share the lock
+template<class T>
+class ReadMostlyTable {
+public:
+	explicit ReadMostlyTable(const T& initial) : m_table(initial) {}
+	template<class Read>
+	auto read(const Read& read) const {
+		QReadLocker locker(&m_lock);
+		return read(m_table);
+	}
+	template<class Update>
+	auto update(const Update& update) {
+		QWriteLocker locker(&m_lock);
+		return update(m_table);
+	}
+
+private:
+	T m_table;
+	mutable QReadWriteLock m_lock;
+};
+
+struct AttrNameTable {
+	QHash<QString, quint16> ids;
+	QVector<QString> names;
+};
+
+static ReadMostlyTable<AttrNameTable>& attrNames() {
+	// Populated with the common names up front, so that the table usually is not modified while parsing
+	static ReadMostlyTable<AttrNameTable> names([] {
+		AttrNameTable table;
+		for(const char* name : {"class", "id", "title", "lang", "dir", "bbox", "baseline", "x_wconf", "x_fsize", "x_font", "x_size",
+		                        "x_descenders", "x_ascenders", "image", "ppageno", "rot", "res", "scan_res", "textangle"}) {
+			table.ids.insert(name, table.names.size());
+			table.names.append(name);
+		}
+		return table;
+	}());
+	return names;
+}
+
+int HOCRAttributes::lookupNameId(const QString& name) {
+	return attrNames().read([&](const AttrNameTable& table) {
+		return table.ids.value(name, -1);
+	});
+}
+
+quint16 HOCRAttributes::nameId(const QString& name) {
+	int id = lookupNameId(name);
+	if(id >= 0) {
+		return id;
+	}
+	return attrNames().update([&](AttrNameTable& table) {
+		auto it = table.ids.find(name);
+		if(it == table.ids.end()) {
+			it = table.ids.insert(name, table.names.size());
+			table.names.append(name);
+		}
+		return it.value();
+	});
+}
+
+QString HOCRAttributes::name(quint16 id) {
+	return attrNames().read([&](const AttrNameTable& table) {
+		return table.names[id];
+	});
+}
+
+QString HOCRAttributes::intern(const QString& string) {
+	static ReadMostlyTable<QSet<QString>> strings((QSet<QString>()));
+	QString result = strings.read([&](const QSet<QString>& table) {
+		auto it = table.constFind(string);
+		return it != table.constEnd() ? *it : QString();
+	});
+	if(!result.isNull() || string.isNull()) {
+		return result;
+	}
+	return strings.update([&](QSet<QString>& table) {
+		auto it = table.constFind(string);
+		if(it == table.constEnd()) {
+			it = table.insert(string);
+		}
+		return *it;
+	});
+}
+
+int HOCRAttributes::find(const QString& name) const {
+	if(m_entries.isEmpty()) {
+		return -1;
+	}
+	int id = lookupNameId(name);
+	for(int i = 0, n = m_entries.size(); i < n; ++i) {
+		if(m_entries[i].first == id) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void HOCRAttributes::insert(const QString& name, const QString& value) {
+	static const QStringList internedValues = {"class", "dir", "lang", "x_font"};
+	QString storedValue = internedValues.contains(name) ? intern(value) : value;
+	int idx = find(name);
+	if(idx >= 0) {
+		m_entries[idx].second = storedValue;
+	} else {
+		m_entries.append(qMakePair(nameId(name), storedValue));
+	}
+}
+
+void HOCRAttributes::writeBinary(HOCRBinaryWriter& writer) const {
+	writer.stream() << quint32(m_entries.size());
+	for(const QPair<quint16, QString>& entry : m_entries) {
+		writer.writeString(name(entry.first));
+		writer.writeString(entry.second);
+	}
+}
+
+void HOCRAttributes::readBinary(HOCRBinaryReader& reader) {
+	quint32 count = 0;
+	reader.stream() >> count;
+	m_entries.clear();
+	for(quint32 i = 0; i < count && reader.ok(); ++i) {
+		QString attrName = reader.readString();
+		QString value = reader.readString();
+		m_entries.append(qMakePair(nameId(attrName), value));
+	}
+}
+
+void HOCRAttributes::remove(const QString& name) {
+	int idx = find(name);
+	if(idx >= 0) {
+		m_entries.remove(idx);
+	}
+}
+
+void HOCRAttributes::addToMap(QMap<QString, QString>& map, const QString& prefix) const {
+	for(const auto& entry : m_entries) {
+		map.insert(prefix + name(entry.first), entry.second);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct LanguageTable {
+	// Index 0 is reserved for the empty language
+	QVector<HOCRLanguage*> langs = {nullptr};
+	QHash<QString, HOCRLanguage*> ids;
+};
+
+static ReadMostlyTable<LanguageTable>& languages() {
+	static ReadMostlyTable<LanguageTable> table((LanguageTable()));
+	return table;
+}
+
+const HOCRLanguage* HOCRLanguage::intern(const QString& lang) {
+	if(lang.isEmpty()) {
+		return nullptr;
+	}
+	const HOCRLanguage* language = languages().read([&](const LanguageTable& table) {
+		return table.ids.value(lang);
+	});
+	if(language) {
+		return language;
+	}
+	return languages().update([&](LanguageTable& table) -> const HOCRLanguage* {
+		HOCRLanguage*& language = table.ids[lang];
+		if(!language) {
+			language = new HOCRLanguage(table.langs.size(), HOCRAttributes::intern(lang));
+			table.langs.append(language);
+		}
+		return language;
+	});
+}
+
+const HOCRLanguage* HOCRLanguage::fromId(int id) {
+	return languages().read([&](const LanguageTable& table) {
+		return table.langs.value(id);
+	});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 QMap<QString, QString> HOCRItem::s_langCache = QMap<QString, QString>();
+QReadWriteLock HOCRItem::s_langCacheLock;
 
 QMap<QString, QString> HOCRItem::deserializeAttrGroup(const QString& string) {
 	QMap<QString, QString> attrs;
-	for(const QString& attr : string.split(QRegularExpression("\\s*;\\s*"))) {
-		int splitPos = attr.indexOf(QRegularExpression("\\s+"));
-		attrs.insert(attr.left(splitPos), splitPos > 0 ? attr.mid(splitPos + 1) : "");
+	HOCRTitleTokenizer tokenizer(string);
+	while(tokenizer.next()) {
+		attrs.insert(tokenizer.name().toString(), tokenizer.value().toString());
 	}
 	return attrs;
 }
@@ -800,6 +2318,18 @@ QString HOCRItem::trimmedWord(const QString& word, QString* prefix, QString* suf
 	return word;
 }
 
+// Indexed by HOCRItem::ItemClass
+static const char* const s_itemClassNames[] = {"ocr_page", "ocr_carea", "ocr_par", "ocr_line", "ocrx_word", "ocr_graphic"};
+
+HOCRItem::ItemClass HOCRItem::itemClassFromName(const QString& name) {
+	for(int i = 0; i <= int(ItemClass::Graphic); ++i) {
+		if(name == QLatin1String(s_itemClassNames[i])) {
+			return ItemClass(i);
+		}
+	}
+	return ItemClass::Other;
+}
+
 HOCRItem::HOCRItem(const QDomElement& element, HOCRPage* page, HOCRItem* parent, int index)
 	: m_pageItem(page), m_parentItem(parent), m_index(index) {
 	// Read attrs
@@ -807,39 +2337,89 @@ HOCRItem::HOCRItem(const QDomElement& element, HOCRPage* page, HOCRItem* parent,
 	for(int i = 0, n = attributes.size(); i < n; ++i) {
 		QString attrName = attributes.item(i).nodeName();
 		if(attrName == "title") {
-			m_titleAttrs = deserializeAttrGroup(attributes.item(i).nodeValue());
+			parseTitleAttributes(attributes.item(i).nodeValue());
 		} else {
-			m_attrs[attrName] = attributes.item(i).nodeValue();
+			setPlainAttribute(attrName, attributes.item(i).nodeValue());
 		}
 	}
-	// Map ocr_header/ocr_caption/ocr_textfloat to ocr_line
-	if(m_attrs["class"] == "ocr_header" || m_attrs["class"] == "ocr_caption" || m_attrs["class"] == "ocr_textfloat") {
-		m_attrs["class"] = "ocr_line";
+	initAttributes();
+
+	if(m_class == ItemClass::Word) {
+		m_text = element.text();
+		m_bold = !element.elementsByTagName("strong").isEmpty();
+		m_italic = !element.elementsByTagName("em").isEmpty();
 	}
-	// Adjust item id based on pageId
-	if(parent) {
-		QString idClass = itemClass().mid(itemClass().indexOf("_") + 1);
-		int counter = page->m_idCounters.value(idClass, 0) + 1;
-		page->m_idCounters[idClass] = counter;
-		QString newId = QString("%1_%2_%3").arg(idClass).arg(page->pageId()).arg(counter);
-		m_attrs["id"] = newId;
+}
+
+HOCRItem::HOCRItem(QXmlStreamReader& reader, HOCRPage* page, HOCRItem* parent, int index)
+	: m_pageItem(page), m_parentItem(parent), m_index(index) {
+	// Read attrs, the content is consumed by parseChildren
+	for(const QXmlStreamAttribute& attribute : reader.attributes()) {
+		QString attrName = attribute.qualifiedName().toString();
+		if(attrName == "title") {
+			parseTitleAttributes(attribute.value());
+		} else {
+			setPlainAttribute(attrName, attribute.value().toString());
+		}
 	}
+	initAttributes();
+}
 
-	// Parse item bbox
-	QStringList bbox = m_titleAttrs["bbox"].split(QRegularExpression("\\s+"));
-	if(bbox.size() == 4) {
-		m_bbox.setCoords(bbox[0].toInt(), bbox[1].toInt(), bbox[2].toInt(), bbox[3].toInt());
+HOCRItem::HOCRItem(HOCRBinaryReader& reader, HOCRPage* page, HOCRItem* parent, int index)
+	: m_pageItem(page), m_parentItem(parent), m_index(index) {
+	QDataStream& ds = reader.stream();
+	quint8 itemClass = 0, idClass = 0, flags = 0;
+	qint32 idCounter = 0, x1 = 0, y1 = 0, x2 = 0, y2 = 0, wconf = 0;
+	ds >> itemClass >> idClass >> m_nativeAttrs >> m_misspelled >> flags >> idCounter;
+	m_class = ItemClass(std::min(itemClass, quint8(ItemClass::Other)));
+	m_idClass = ItemClass(std::min(idClass, quint8(ItemClass::Other)));
+	m_bold = flags & 1;
+	m_italic = flags & 2;
+	m_enabled = flags & 4;
+	m_idCounter = idCounter;
+	m_text = reader.readString();
+	m_attrs.readBinary(reader);
+	m_titleAttrs.readBinary(reader);
+	m_lang = HOCRLanguage::intern(m_attrs.value("lang"));
+	ds >> x1 >> y1 >> x2 >> y2 >> m_baseline[0] >> m_baseline[1] >> m_fsize >> wconf;
+	m_bbox.setCoords(x1, y1, x2, y2);
+	m_wconf = wconf;
+
+	// As in initAttributes, generated ids are based on the id of the page in this session
+	if(m_parentItem && m_idCounter != 0 && m_idClass != ItemClass::Other) {
+		QString cls = s_itemClassNames[int(m_idClass)];
+		int& counter = m_pageItem->m_idCounters[cls.mid(cls.indexOf("_") + 1)];
+		counter = std::max(counter, m_idCounter);
+		m_idPageId = m_pageItem->pageId();
 	}
+}
 
-	if(itemClass() == "ocrx_word") {
-		m_text = element.text();
-		m_bold = !element.elementsByTagName("strong").isEmpty();
-		m_italic = !element.elementsByTagName("em").isEmpty();
-	} else if(itemClass() == "ocr_line") {
-		// Depending on the locale, tesseract can use a comma instead of a dot as decimal separator in the baseline...
-		m_titleAttrs["baseline"] = m_titleAttrs["baseline"].replace(",", ".");
-		m_misspelled = false;
-	} else {
+void HOCRItem::initAttributes() {
+	// Map ocr_header/ocr_caption/ocr_textfloat to ocr_line
+	if(m_class == ItemClass::Other) {
+		QString cls = m_attrs.value("class");
+		if(cls == "ocr_header" || cls == "ocr_caption" || cls == "ocr_textfloat") {
+			setPlainAttribute("class", "ocr_line");
+		}
+	}
+	// Adjust item id based on pageId
+	if(m_parentItem) {
+		QString cls = itemClass();
+		QString idClass = cls.mid(cls.indexOf("_") + 1);
+		int counter = m_pageItem->m_idCounters.value(idClass, 0) + 1;
+		m_pageItem->m_idCounters[idClass] = counter;
+		if(m_class == ItemClass::Other) {
+			setPlainAttribute("id", QString("%1_%2_%3").arg(idClass).arg(m_pageItem->pageId()).arg(counter));
+		} else {
+			// Stored compactly, the id string is generated on demand
+			m_attrs.remove("id");
+			m_idClass = m_class;
+			m_idPageId = m_pageItem->pageId();
+			m_idCounter = counter;
+		}
+	}
+
+	if(m_class != ItemClass::Word) {
 		m_misspelled = false;
 	}
 }
@@ -849,20 +2429,30 @@ HOCRItem::~HOCRItem() {
 }
 
 void HOCRItem::addChild(HOCRItem* child) {
+	if(m_childrenEvicted.loadAcquire()) {
+		restoreChildren();
+	}
+	setModified();
 	m_childItems.append(child);
 	child->m_parentItem = this;
-	child->m_pageItem = m_pageItem;
+	child->setPage(m_pageItem);
 	child->m_index = m_childItems.size() - 1;
+	m_pageItem->gridInsert(child, true);
 }
 
 void HOCRItem::insertChild(HOCRItem* child, int i) {
+	if(m_childrenEvicted.loadAcquire()) {
+		restoreChildren();
+	}
+	setModified();
 	m_childItems.insert(i, child);
 	child->m_parentItem = this;
-	child->m_pageItem = m_pageItem;
+	child->setPage(m_pageItem);
 	child->m_index = i++;
 	for(int n = m_childItems.size(); i < n; ++i) {
 		m_childItems[i]->m_index = i;
 	}
+	m_pageItem->gridInsert(child, true);
 }
 
 void HOCRItem::removeChild(HOCRItem* child) {
@@ -874,6 +2464,8 @@ void HOCRItem::takeChild(HOCRItem* child) {
 	if(this != child->parent()) {
 		return;
 	}
+	setModified();
+	m_pageItem->gridRemove(child, true);
 	int i = child->index();
 	m_childItems.remove(i);
 	for(int n = m_childItems.size(); i < n; ++i) {
@@ -882,20 +2474,214 @@ void HOCRItem::takeChild(HOCRItem* child) {
 }
 
 QVector<HOCRItem*> HOCRItem::takeChildren() {
+	if(m_childrenEvicted.loadAcquire()) {
+		restoreChildren();
+	}
+	setModified();
 	QVector<HOCRItem*> children(m_childItems);
+	for(const HOCRItem* child : children) {
+		m_pageItem->gridRemove(child, true);
+	}
 	m_childItems.clear();
 	return children;
 }
 
-QMap<QString, QString> HOCRItem::getAllAttributes() const {
-	QMap<QString, QString> attrValues;
-	for(auto it = m_attrs.begin(), itEnd = m_attrs.end(); it != itEnd; ++it) {
-		attrValues.insert(it.key(), it.value());
+void HOCRItem::setPage(HOCRPage* page) {
+	m_pageItem = page;
+	for(HOCRItem* child : m_childItems) {
+		child->setPage(page);
+	}
+}
+
+int HOCRItem::childCount() const {
+	return m_childrenEvicted.loadAcquire() ? static_cast<const HOCRPage*>(this)->m_evictedChildCount : m_childItems.size();
+}
+
+void HOCRItem::restoreChildren() const {
+	// Only pages evict their children
+	const_cast<HOCRPage*>(static_cast<const HOCRPage*>(this))->restoreEvictedChildren();
+}
+
+void HOCRItem::setModified() {
+	if(m_pageItem) {
+		m_pageItem->m_modified = true;
+		++m_pageItem->m_revision;
+		m_pageItem->m_memoryCost = 0;
+		m_pageItem->m_textIndex.reset();
+		m_pageItem->m_misspelledWords.reset();
+	}
+}
+
+qint64 HOCRItem::memoryCost() const {
+	// Rough estimate, attribute values are mostly interned or shared
+	qint64 cost = sizeof(*this) + m_text.capacity() * sizeof(QChar) + (m_attrs.size() + m_titleAttrs.size()) * 32 + m_childItems.capacity() * sizeof(HOCRItem*);
+	for(const HOCRItem* child : m_childItems) {
+		cost += child->memoryCost();
+	}
+	return cost;
+}
+
+void HOCRItem::setEnabled(bool enabled) {
+	m_enabled = enabled;
+	setModified();
+}
+
+void HOCRItem::setMisspelled(int misspelled) {
+	if(misspelled != m_misspelled && m_pageItem) {
+		m_pageItem->m_misspelledWords.reset();
+	}
+	m_misspelled = misspelled;
+}
+
+void HOCRItem::setText(const QString& newText) {
+	m_text = newText;
+	setModified();
+}
+
+QString HOCRItem::itemClass() const {
+	return m_class == ItemClass::Other ? m_attrs.value("class") : QString(s_itemClassNames[int(m_class)]);
+}
+
+QString HOCRItem::attribute(const QString& name) const {
+	if(name == "class") {
+		return itemClass();
+	} else if(name == "id" && m_idCounter > 0) {
+		QString idClass = QString(s_itemClassNames[int(m_idClass)]);
+		return QString("%1_%2_%3").arg(idClass.mid(idClass.indexOf("_") + 1)).arg(m_idPageId).arg(m_idCounter);
+	}
+	return m_attrs.value(name);
+}
+
+QString HOCRItem::titleAttribute(const QString& name) const {
+	if(name == "bbox" && (m_nativeAttrs & HasBBox)) {
+		return QString("%1 %2 %3 %4").arg(m_bbox.left()).arg(m_bbox.top()).arg(m_bbox.right()).arg(m_bbox.bottom());
+	} else if(name == "baseline" && (m_nativeAttrs & HasBaseline)) {
+		return formatNumbers(m_baseline, 2);
+	} else if(name == "x_wconf" && (m_nativeAttrs & HasWConf)) {
+		return QString::number(m_wconf);
+	} else if(name == "x_fsize" && (m_nativeAttrs & HasFSize)) {
+		return formatNumbers(&m_fsize, 1);
+	}
+	return m_titleAttrs.value(name);
+}
+
+QMap<QString, QString> HOCRItem::getAttributes() const {
+	QMap<QString, QString> attrs;
+	m_attrs.addToMap(attrs);
+	if(m_class != ItemClass::Other) {
+		attrs.insert("class", itemClass());
+	}
+	if(m_idCounter > 0) {
+		attrs.insert("id", attribute("id"));
+	}
+	return attrs;
+}
+
+QMap<QString, QString> HOCRItem::getTitleAttributes() const {
+	QMap<QString, QString> attrs;
+	m_titleAttrs.addToMap(attrs);
+	static const QStringList nativeAttrs = {"bbox", "baseline", "x_wconf", "x_fsize"};
+	for(int i = 0; i < nativeAttrs.size(); ++i) {
+		if(m_nativeAttrs & (1 << i)) {
+			attrs.insert(nativeAttrs[i], titleAttribute(nativeAttrs[i]));
+		}
 	}
-	for(auto it = m_titleAttrs.begin(), itEnd = m_titleAttrs.end(); it != itEnd; ++it) {
+	return attrs;
+}
+
+void HOCRItem::writeAttributes(HOCRHtmlWriter& writer) const {
+	// Same order as getAttributes(), i.e. sorted by name
+	bool nativeClass = m_class != ItemClass::Other;
+	bool nativeId = m_idCounter > 0;
+	QVarLengthArray<QPair<QString, int>, 8> entries;
+	for(int i = 0, n = m_attrs.size(); i < n; ++i) {
+		QString name = m_attrs.nameAt(i);
+		if(!(nativeClass && name == QLatin1String("class")) && !(nativeId && name == QLatin1String("id"))) {
+			entries.append(qMakePair(name, i));
+		}
+	}
+	if(nativeClass) {
+		entries.append(qMakePair(QString("class"), -1));
+	}
+	if(nativeId) {
+		entries.append(qMakePair(QString("id"), -2));
+	}
+	std::sort(entries.begin(), entries.end(), [](const QPair<QString, int>& a, const QPair<QString, int>& b) {
+		return a.first < b.first;
+	});
+	for(const QPair<QString, int>& entry : entries) {
+		writer << " " << entry.first << "=\"";
+		if(entry.second == -1) {
+			writer << s_itemClassNames[int(m_class)];
+		} else if(entry.second == -2) {
+			const char* idClass = s_itemClassNames[int(m_idClass)];
+			writer << (std::strchr(idClass, '_') + 1) << "_" << m_idPageId << "_" << m_idCounter;
+		} else {
+			writer << m_attrs.valueAt(entry.second);
+		}
+		writer << "\"";
+	}
+}
+
+void HOCRItem::writeTitleAttributes(HOCRHtmlWriter& writer) const {
+	// Same output as serializeAttrGroup(getTitleAttributes()), with the native attributes in name order
+	static const char* const nativeNames[] = {"baseline", "bbox", "x_fsize", "x_wconf"};
+	static const NativeAttr nativeFlags[] = {HasBaseline, HasBBox, HasFSize, HasWConf};
+	QVarLengthArray<QPair<QString, int>, 8> others;
+	for(int i = 0, n = m_titleAttrs.size(); i < n; ++i) {
+		others.append(qMakePair(m_titleAttrs.nameAt(i), i));
+	}
+	std::sort(others.begin(), others.end(), [](const QPair<QString, int>& a, const QPair<QString, int>& b) {
+		return a.first < b.first;
+	});
+	bool first = true;
+	auto separator = [&] {
+		if(!first) {
+			writer << "; ";
+		}
+		first = false;
+	};
+	int other = 0;
+	for(int i = 0; i <= 4; ++i) {
+		// Other attributes sorting before the next native attribute
+		while(other < others.size() && (i == 4 || others[other].first < QLatin1String(nativeNames[i]))) {
+			separator();
+			writer << others[other].first << " " << m_titleAttrs.valueAt(others[other].second);
+			++other;
+		}
+		if(i == 4 || !(m_nativeAttrs & nativeFlags[i])) {
+			continue;
+		}
+		// A native attribute replaces a verbatim one with the same name
+		if(other < others.size() && others[other].first == QLatin1String(nativeNames[i])) {
+			++other;
+		}
+		separator();
+		writer << nativeNames[i] << " ";
+		switch(nativeFlags[i]) {
+		case HasBaseline:
+			writer << formatNumbers(m_baseline, 2);
+			break;
+		case HasBBox:
+			writer << m_bbox.left() << " " << m_bbox.top() << " " << m_bbox.right() << " " << m_bbox.bottom();
+			break;
+		case HasFSize:
+			writer << formatNumbers(&m_fsize, 1);
+			break;
+		case HasWConf:
+			writer << m_wconf;
+			break;
+		}
+	}
+}
+
+QMap<QString, QString> HOCRItem::getAllAttributes() const {
+	QMap<QString, QString> attrValues = getAttributes();
+	QMap<QString, QString> titleAttrs = getTitleAttributes();
+	for(auto it = titleAttrs.begin(), itEnd = titleAttrs.end(); it != itEnd; ++it) {
 		attrValues.insert(QString("title:%1").arg(it.key()), it.value());
 	}
-	if(itemClass() == "ocrx_word") {
+	if(m_class == ItemClass::Word) {
 		if(!attrValues.contains("title:x_font")) {
 			attrValues.insert("title:x_font", "");
 		}
@@ -905,19 +2691,19 @@ QMap<QString, QString> HOCRItem::getAllAttributes() const {
 	return attrValues;
 }
 
-QMap<QString, QString> HOCRItem::getAttributes(const QList<QString>& names = QList<QString>()) const {
+QMap<QString, QString> HOCRItem::getAttributes(const QList<QString>& names) const {
 	QMap<QString, QString> attrValues;
 	for(const QString& attrName : names) {
 		QStringList parts = attrName.split(":");
 		if(parts.size() > 1) {
 			Q_ASSERT(parts[0] == "title");
-			attrValues.insert(attrName, m_titleAttrs.value(parts[1]));
+			attrValues.insert(attrName, titleAttribute(parts[1]));
 		} else if(attrName == "bold") {
 			attrValues.insert(attrName, fontBold() ? "1" : "0");
 		} else if(attrName == "italic") {
 			attrValues.insert(attrName, fontItalic() ? "1" : "0");
 		} else {
-			attrValues.insert(attrName, m_attrs[attrName]);
+			attrValues.insert(attrName, attribute(attrName));
 		}
 	}
 	return attrValues;
@@ -930,10 +2716,11 @@ void HOCRItem::getPropagatableAttributes(QMap<QString, QMap<QString, QSet<QStrin
 		{"ocrx_word", {"lang", "title:x_fsize", "title:x_font", "bold", "italic"}}
 	};
 
-	QString childClass = m_childItems.isEmpty() ? "" : m_childItems.front()->itemClass();
+	const QVector<HOCRItem*>& childItems = children();
+	QString childClass = childItems.isEmpty() ? "" : childItems.front()->itemClass();
 	auto it = s_propagatableAttributes.find(childClass);
 	if(it != s_propagatableAttributes.end()) {
-		for(HOCRItem* child : m_childItems) {
+		for(HOCRItem* child : childItems) {
 			QMap<QString, QString> attrs = child->getAttributes(it.value());
 			for(auto attrIt = attrs.begin(), attrItEnd = attrs.end(); attrIt != attrItEnd; ++attrIt) {
 				occurrences[childClass][attrIt.key()].insert(attrIt.value());
@@ -941,7 +2728,7 @@ void HOCRItem::getPropagatableAttributes(QMap<QString, QMap<QString, QSet<QStrin
 		}
 	}
 	if(childClass != "ocrx_word") {
-		for(HOCRItem* child : m_childItems) {
+		for(HOCRItem* child : childItems) {
 			child->getPropagatableAttributes(occurrences);
 		}
 	}
@@ -949,143 +2736,593 @@ void HOCRItem::getPropagatableAttributes(QMap<QString, QMap<QString, QSet<QStrin
 
 void HOCRItem::setAttribute(const QString& name, const QString& value, const QString& attrItemClass) {
 	if(!attrItemClass.isEmpty() && itemClass() != attrItemClass) {
-		for(HOCRItem* child : m_childItems) {
+		for(HOCRItem* child : children()) {
 			child->setAttribute(name, value, attrItemClass);
 		}
 		return;
 	}
+	setModified();
 	QStringList parts = name.split(":");
 	if(name == "bold") {
 		m_bold = value == "1";
 	} else if(name == "italic") {
 		m_italic = value == "1";
 	} else if(parts.size() < 2) {
-		m_attrs[name] = value;
+		setPlainAttribute(name, value);
 	} else {
 		Q_ASSERT(parts[0] == "title");
-		m_titleAttrs[parts[1]] = value;
-		if(name == "title:bbox") {
-			QStringList bbox = value.split(QRegularExpression("\\s+"));
-			Q_ASSERT(bbox.size() == 4);
-			m_bbox.setCoords(bbox[0].toInt(), bbox[1].toInt(), bbox[2].toInt(), bbox[3].toInt());
+		setTitleAttribute(parts[1], value);
+	}
+}
+
+void HOCRItem::setPlainAttribute(const QString& name, const QString& value) {
+	if(name == "class") {
+		m_class = itemClassFromName(value);
+		if(m_class == ItemClass::Other) {
+			m_attrs.insert(name, value);
+		} else {
+			m_attrs.remove(name);
 		}
+	} else {
+		if(name == "id") {
+			m_idCounter = 0;
+		} else if(name == "lang") {
+			m_lang = HOCRLanguage::intern(value);
+		}
+		m_attrs.insert(name, value);
 	}
 }
 
+void HOCRItem::setTitleAttribute(const QString& name, const QString& value) {
+	setTitleAttribute(QStringView(name), QStringView(value));
+}
+
+void HOCRItem::setTitleAttribute(QStringView name, QStringView value) {
+	// Store the numeric attributes parsed if they are well-formed, otherwise keep them verbatim. Fractional
+	// values are only stored parsed if they are written back unchanged (except for decimal commas, which are
+	// normalized), so that saving keeps untouched items as is.
+	bool ok = false;
+	NativeAttr attr = NativeAttr(0);
+	if(name == QLatin1String("bbox")) {
+		int coords[4];
+		ok = parseNumbers(value, coords, 4);
+		if(ok) {
+			m_bbox.setCoords(coords[0], coords[1], coords[2], coords[3]);
+			// The page is still being constructed when its own attributes are set
+			if(m_pageItem && m_pageItem != this) {
+				m_pageItem->gridUpdate(this);
+			}
+		}
+		attr = HasBBox;
+	} else if(name == QLatin1String("baseline")) {
+		float baseline[2];
+		ok = parseNumbers(value, baseline, 2) && matchesFormatted(value, formatNumbers(baseline, 2));
+		if(ok) {
+			m_baseline[0] = baseline[0];
+			m_baseline[1] = baseline[1];
+		}
+		attr = HasBaseline;
+	} else if(name == QLatin1String("x_wconf")) {
+		int wconf;
+		ok = parseNumbers(value, &wconf, 1);
+		if(ok) {
+			m_wconf = wconf;
+		}
+		attr = HasWConf;
+	} else if(name == QLatin1String("x_fsize")) {
+		float fsize;
+		ok = parseNumbers(value, &fsize, 1) && matchesFormatted(value, formatNumbers(&fsize, 1));
+		if(ok) {
+			m_fsize = fsize;
+		}
+		attr = HasFSize;
+	}
+	if(ok) {
+		m_nativeAttrs |= attr;
+		if(!m_titleAttrs.isEmpty()) {
+			m_titleAttrs.remove(name.toString());
+		}
+	} else {
+		m_nativeAttrs &= ~attr;
+		m_titleAttrs.insert(name.toString(), value.toString());
+	}
+}
+
+void HOCRItem::parseTitleAttributes(QStringView title) {
+	HOCRTitleTokenizer tokenizer(title);
+	while(tokenizer.next()) {
+		setTitleAttribute(tokenizer.name(), tokenizer.value());
+	}
+}
+
+void HOCRItem::removeTitleAttribute(const QString& name) {
+	static const QStringList nativeAttrs = {"bbox", "baseline", "x_wconf", "x_fsize"};
+	int idx = nativeAttrs.indexOf(name);
+	if(idx >= 0) {
+		m_nativeAttrs &= ~(1 << idx);
+	}
+	m_titleAttrs.remove(name);
+}
+
 QString HOCRItem::toHtml(int indent) const {
-	QString cls = itemClass();
-	QString tag;
-	if(cls == "ocr_page" || cls == "ocr_carea" || cls == "ocr_graphic") {
+	QByteArray html;
+	QBuffer buffer(&html);
+	buffer.open(QIODevice::WriteOnly);
+	HOCRHtmlWriter writer(&buffer);
+	writeHtml(writer, indent);
+	writer.flush();
+	return QString::fromUtf8(html);
+}
+
+void HOCRItem::writeHtml(HOCRHtmlWriter& writer, int indent, const QVector<HOCRItem*>& children) const {
+	const char* tag;
+	if(m_class == ItemClass::Page || m_class == ItemClass::CArea || m_class == ItemClass::Graphic) {
 		tag = "div";
-	} else if(cls == "ocr_par") {
+	} else if(m_class == ItemClass::Par) {
 		tag = "p";
 	} else {
 		tag = "span";
 	}
-	QString html = QString(indent, ' ') + "<" + tag;
-	html += QString(" title=\"%1\"").arg(serializeAttrGroup(m_titleAttrs));
-	for(auto it = m_attrs.begin(), itEnd = m_attrs.end(); it != itEnd; ++it) {
-		html += QString(" %1=\"%2\"").arg(it.key(), it.value());
-	}
-	html += ">";
-	if(cls == "ocrx_word") {
+	writer.indent(indent) << "<" << tag;
+	writer << " title=\"";
+	writeTitleAttributes(writer);
+	writer << "\"";
+	writeAttributes(writer);
+	writer << ">";
+	if(m_class == ItemClass::Word) {
 		if(m_bold) {
-			html += "<strong>";
+			writer << "<strong>";
 		}
 		if(m_italic) {
-			html += "<em>";
+			writer << "<em>";
 		}
-		html += m_text.toHtmlEscaped();
+		writer << m_text.toHtmlEscaped();
 		if(m_italic) {
-			html += "</em>";
+			writer << "</em>";
 		}
 		if(m_bold) {
-			html += "</strong>";
+			writer << "</strong>";
 		}
 	} else {
-		html += "\n";
-		for(const HOCRItem* child : m_childItems) {
-			html += child->toHtml(indent + 1);
+		writer << "\n";
+		for(const HOCRItem* child : children) {
+			child->writeHtml(writer, indent + 1);
+		}
+		writer.indent(indent);
+	}
+	writer << "</" << tag << ">\n";
+}
+
+void HOCRItem::writeBinary(HOCRBinaryWriter& writer, bool recursive) const {
+	QDataStream& ds = writer.stream();
+	quint8 flags = (m_bold ? 1 : 0) | (m_italic ? 2 : 0) | (m_enabled ? 4 : 0);
+	ds << quint8(m_class) << quint8(m_idClass) << m_nativeAttrs << m_misspelled << flags << qint32(m_idCounter);
+	writer.writeString(m_text);
+	m_attrs.writeBinary(writer);
+	m_titleAttrs.writeBinary(writer);
+	ds << qint32(m_bbox.left()) << qint32(m_bbox.top()) << qint32(m_bbox.right()) << qint32(m_bbox.bottom());
+	ds << m_baseline[0] << m_baseline[1] << m_fsize << qint32(m_wconf);
+	if(recursive) {
+		const QVector<HOCRItem*>& childItems = children();
+		ds << quint32(childItems.size());
+		for(const HOCRItem* child : childItems) {
+			child->writeBinary(writer, true);
 		}
-		html += QString(indent, ' ');
 	}
-	html += "</" + tag + ">\n";
-	return html;
 }
 
 QPair<double, double> HOCRItem::baseLine() const {
-	static const QRegularExpression baseLineRx = QRegularExpression("([+-]?\\d+\\.?\\d*)\\s+([+-]?\\d+\\.?\\d*)");
-	QRegularExpressionMatch match;
-	if((match = baseLineRx.match(m_titleAttrs["baseline"])).hasMatch()) {
-		return qMakePair(match.captured(1).toDouble(), match.captured(2).toDouble());
+	if(m_nativeAttrs & HasBaseline) {
+		return qMakePair(double(m_baseline[0]), double(m_baseline[1]));
+	}
+	float baseline[2];
+	if(parseNumbers(QStringView(m_titleAttrs.value("baseline")), baseline, 2)) {
+		return qMakePair(double(baseline[0]), double(baseline[1]));
 	}
 	return qMakePair(0.0, 0.0);
 }
 
-bool HOCRItem::parseChildren(const QDomElement& element, QString language, const QString& defaultLanguage) {
+QString HOCRItem::itemLanguage(const QString& elemLang, const QString& language, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs) {
 	// Determine item language (inherit from parent if not specified)
-	QString elemLang = element.attribute("lang");
-	if(!elemLang.isEmpty()) {
-		auto it = s_langCache.find(elemLang);
-		if(it == s_langCache.end()) {
-			it = s_langCache.insert(elemLang, Utils::getSpellingLanguage(elemLang, defaultLanguage));
+	if(elemLang.isEmpty()) {
+		return language;
+	}
+	// Pages may be parsed concurrently, resolve unknown languages outside of the lock
+	m_attrs.remove("lang");
+	m_lang = nullptr;
+	{
+		QReadLocker locker(&s_langCacheLock);
+		auto it = s_langCache.constFind(elemLang);
+		if(it != s_langCache.constEnd()) {
+			return it.value();
 		}
-		m_attrs.remove("lang");
-		language = it.value();
 	}
+	QString spellingLanguage = Utils::getSpellingLanguage(elemLang, defaultLanguage, langSpecs);
+	QWriteLocker locker(&s_langCacheLock);
+	return s_langCache.insert(elemLang, spellingLanguage).value();
+}
+
+bool HOCRItem::parseChildren(const QDomElement& element, QString language, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs) {
+	language = itemLanguage(element.attribute("lang"), language, defaultLanguage, langSpecs);
 
-	if(itemClass() == "ocrx_word") {
-		m_attrs["lang"] = language;
+	if(m_class == ItemClass::Word) {
+		setPlainAttribute("lang", language);
 		return !m_text.isEmpty();
 	}
 	bool haveWords = false;
 	QDomElement childElement = element.firstChildElement();
 	while(!childElement.isNull()) {
 		m_childItems.append(new HOCRItem(childElement, m_pageItem, this, m_childItems.size()));
-		haveWords |= m_childItems.last()->parseChildren(childElement, language, defaultLanguage);
+		haveWords |= m_childItems.last()->parseChildren(childElement, language, defaultLanguage, langSpecs);
 		childElement = childElement.nextSiblingElement();
 	}
 	return haveWords;
 }
 
+bool HOCRItem::parseChildren(QXmlStreamReader& reader, QString language, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs) {
+	language = itemLanguage(m_attrs.value("lang"), language, defaultLanguage, langSpecs);
+
+	if(m_class == ItemClass::Word) {
+		// Collect the text of all descendants, noting any formatting elements
+		int depth = 0;
+		while(!reader.atEnd()) {
+			QXmlStreamReader::TokenType token = reader.readNext();
+			if(token == QXmlStreamReader::Characters) {
+				m_text += reader.text();
+			} else if(token == QXmlStreamReader::StartElement) {
+				++depth;
+				m_bold |= reader.name() == QLatin1String("strong");
+				m_italic |= reader.name() == QLatin1String("em");
+			} else if(token == QXmlStreamReader::EndElement && depth-- == 0) {
+				break;
+			}
+		}
+		setPlainAttribute("lang", language);
+		return !m_text.isEmpty();
+	}
+	bool haveWords = false;
+	while(reader.readNextStartElement()) {
+		m_childItems.append(new HOCRItem(reader, m_pageItem, this, m_childItems.size()));
+		haveWords |= m_childItems.last()->parseChildren(reader, language, defaultLanguage, langSpecs);
+	}
+	return haveWords;
+}
+
+bool HOCRItem::readBinaryChildren(HOCRBinaryReader& reader) {
+	quint32 count = 0;
+	reader.stream() >> count;
+	for(quint32 i = 0; i < count && reader.ok(); ++i) {
+		HOCRItem* item = new HOCRItem(reader, m_pageItem, this, m_childItems.size());
+		m_childItems.append(item);
+		item->readBinaryChildren(reader);
+	}
+	return reader.ok();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
-HOCRPage::HOCRPage(const QDomElement& element, int pageId, const QString& defaultLanguage, bool cleanGraphics, int index)
+HOCRPage::HOCRPage(const QDomElement& element, int pageId, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs, bool cleanGraphics, int index)
 	: HOCRItem(element, this, nullptr, index), m_pageId(pageId) {
-	m_attrs["id"] = QString("page_%1").arg(pageId);
-
-	m_sourceFile = m_titleAttrs["image"].replace(QRegularExpression("^['\"]"), "").replace(QRegularExpression("['\"]$"), "");
-	m_pageNr = m_titleAttrs["ppageno"].toInt();
-	// Code to handle pageno -> ppageno typo in previous versions of gImageReader
-	if(m_pageNr == 0) {
-		m_pageNr = m_titleAttrs["pageno"].toInt();
-		m_titleAttrs["ppageno"] = m_titleAttrs["pageno"];
-		m_titleAttrs.remove("pageno");
-	}
-	m_angle = m_titleAttrs["rot"].toDouble();
-	m_resolution = m_titleAttrs.value("res", "100").toInt();
+	initPage();
 
 	QDomElement childElement = element.firstChildElement("div");
 	while(!childElement.isNull()) {
 		HOCRItem* item = new HOCRItem(childElement, this, this, m_childItems.size());
 		m_childItems.append(item);
-		if(!item->parseChildren(childElement, defaultLanguage, defaultLanguage)) {
-			// No word children -> treat as graphic
-			if(cleanGraphics && (item->bbox().width() < 10 || item->bbox().height() < 10)) {
-				// Ignore graphics which are less than 10 x 10
-				delete m_childItems.takeLast();
-			} else {
-				item->setAttribute("class", "ocr_graphic");
-				qDeleteAll(item->m_childItems);
-				item->m_childItems.clear();
+		checkGraphic(item, item->parseChildren(childElement, defaultLanguage, defaultLanguage, langSpecs), cleanGraphics);
+		childElement = childElement.nextSiblingElement();
+	}
+	m_modified = false;
+	m_revision = 0;
+}
+
+HOCRPage::HOCRPage(QXmlStreamReader& reader, int pageId, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs, bool cleanGraphics, int index)
+	: HOCRItem(reader, this, nullptr, index), m_pageId(pageId) {
+	initPage();
+
+	while(reader.readNextStartElement()) {
+		if(reader.name() != QLatin1String("div")) {
+			reader.skipCurrentElement();
+			continue;
+		}
+		HOCRItem* item = new HOCRItem(reader, this, this, m_childItems.size());
+		m_childItems.append(item);
+		checkGraphic(item, item->parseChildren(reader, defaultLanguage, defaultLanguage, langSpecs), cleanGraphics);
+	}
+	m_modified = false;
+	m_revision = 0;
+}
+
+HOCRPage::HOCRPage(HOCRBinaryReader& reader, int pageId, int index)
+	: HOCRItem(reader, this, nullptr, index), m_pageId(pageId) {
+	initPage();
+	m_modified = false;
+	m_revision = 0;
+}
+
+void HOCRPage::initPage() {
+	setPlainAttribute("id", QString("page_%1").arg(m_pageId));
+
+	m_sourceFile = titleAttribute("image").replace(QRegularExpression("^['\"]"), "").replace(QRegularExpression("['\"]$"), "");
+	m_pageNr = titleAttribute("ppageno").toInt();
+	// Code to handle pageno -> ppageno typo in previous versions of gImageReader
+	if(m_pageNr == 0) {
+		m_pageNr = titleAttribute("pageno").toInt();
+		setTitleAttribute("ppageno", titleAttribute("pageno"));
+		removeTitleAttribute("pageno");
+	}
+	m_angle = titleAttribute("rot").toDouble();
+	m_resolution = m_titleAttrs.contains("res") ? titleAttribute("res").toInt() : 100;
+	updateTitle();
+}
+
+void HOCRPage::checkGraphic(HOCRItem* item, bool haveWords, bool cleanGraphics) {
+	if(haveWords) {
+		return;
+	}
+	// No word children -> treat as graphic
+	if(cleanGraphics && (item->bbox().width() < 10 || item->bbox().height() < 10)) {
+		// Ignore graphics which are less than 10 x 10
+		delete m_childItems.takeLast();
+	} else {
+		item->setAttribute("class", "ocr_graphic");
+		qDeleteAll(item->m_childItems);
+		item->m_childItems.clear();
+	}
+}
+
+QVector<HOCRItem*> HOCRPage::itemsAt(const QPoint& pos) const {
+	return itemsInRect(QRect(pos, QSize(1, 1)));
+}
+
+QVector<HOCRItem*> HOCRPage::itemsInRect(const QRect& rect) const {
+	if(!m_grid) {
+		buildGrid();
+	}
+	QVector<HOCRItem*> items;
+	QRect cells = gridCells(rect);
+	bool singleCell = cells.width() == 1 && cells.height() == 1;
+	for(int row = cells.top(); row <= cells.bottom(); ++row) {
+		for(int col = cells.left(); col <= cells.right(); ++col) {
+			for(HOCRItem* item : m_grid->cells[row * m_grid->cols + col]) {
+				// Items spanning multiple cells are reported once
+				if(item->bbox().intersects(rect) && (singleCell || !items.contains(item))) {
+					items.append(item);
+				}
 			}
 		}
-		childElement = childElement.nextSiblingElement();
 	}
+	return items;
+}
+
+void HOCRPage::buildGrid() const {
+	m_grid.reset(new SpatialGrid);
+	m_grid->rect = m_bbox.isValid() ? m_bbox : QRect(0, 0, 1, 1);
+	// Aim for at most 64 x 64 cells, but don't make them smaller than a typical word
+	m_grid->cellSize = std::max(32, std::max(m_grid->rect.width(), m_grid->rect.height()) / 64 + 1);
+	m_grid->cols = m_grid->rect.width() / m_grid->cellSize + 1;
+	m_grid->rows = m_grid->rect.height() / m_grid->cellSize + 1;
+	m_grid->cells.resize(m_grid->cols * m_grid->rows);
+	for(HOCRItem* child : children()) {
+		gridInsert(child, true);
+	}
+}
+
+QRect HOCRPage::gridCells(const QRect& rect) const {
+	// Items outside the page are filed in the border cells
+	auto col = [this](int x) { return qBound(0, (x - m_grid->rect.left()) / m_grid->cellSize, m_grid->cols - 1); };
+	auto row = [this](int y) { return qBound(0, (y - m_grid->rect.top()) / m_grid->cellSize, m_grid->rows - 1); };
+	return QRect(QPoint(col(rect.left()), row(rect.top())), QPoint(col(rect.right()), row(rect.bottom())));
+}
+
+void HOCRPage::gridInsert(HOCRItem* item, bool recursive) const {
+	if(!m_grid) {
+		return;
+	}
+	if(item->bbox().isValid()) {
+		QRect cells = gridCells(item->bbox());
+		for(int row = cells.top(); row <= cells.bottom(); ++row) {
+			for(int col = cells.left(); col <= cells.right(); ++col) {
+				m_grid->cells[row * m_grid->cols + col].append(item);
+			}
+		}
+		m_grid->itemRects.insert(item, item->bbox());
+	}
+	if(recursive) {
+		for(HOCRItem* child : item->children()) {
+			gridInsert(child, true);
+		}
+	}
+}
+
+void HOCRPage::gridRemove(const HOCRItem* item, bool recursive) const {
+	if(!m_grid) {
+		return;
+	}
+	auto it = m_grid->itemRects.find(item);
+	if(it != m_grid->itemRects.end()) {
+		QRect cells = gridCells(it.value());
+		for(int row = cells.top(); row <= cells.bottom(); ++row) {
+			for(int col = cells.left(); col <= cells.right(); ++col) {
+				QVector<HOCRItem*>& cell = m_grid->cells[row * m_grid->cols + col];
+				cell.remove(cell.indexOf(const_cast<HOCRItem*>(item)));
+			}
+		}
+		m_grid->itemRects.erase(it);
+	}
+	if(recursive) {
+		for(const HOCRItem* child : item->children()) {
+			gridRemove(child, true);
+		}
+	}
+}
+
+void HOCRPage::gridUpdate(HOCRItem* item) const {
+	if(!m_grid) {
+		return;
+	}
+	// Items which are not (yet) part of the page tree are indexed when they are inserted
+	for(const HOCRItem* it = item; it != this; it = it->m_parentItem) {
+		if(!it->m_parentItem || it->m_parentItem->m_childItems.value(it->m_index) != it) {
+			return;
+		}
+	}
+	gridRemove(item, false);
+	gridInsert(item, false);
+}
+
+const HOCRPage::TextIndex& HOCRPage::textIndex() const {
+	if(!m_textIndex) {
+		// Evicted pages are restored only for as long as the index is built
+		bool evicted = m_childrenEvicted.loadAcquire();
+		TextIndex* result = new TextIndex;
+		visitItems(this, [result](const HOCRItem* item) {
+			if(item->itemClassId() == ItemClass::Word) {
+				if(item->wordConfidence() < s_lowConfidence) {
+					result->lowConfidence.append(result->offsets.size());
+				}
+				result->offsets.append(result->text.size());
+				result->text.append(item->text());
+				// Search strings never contain a newline, so matches do not span multiple words
+				result->text.append('\n');
+			}
+			return true;
+		});
+		m_textIndex.reset(result);
+		if(evicted) {
+			const_cast<HOCRPage*>(this)->evictChildren();
+		}
+	}
+	return *m_textIndex;
+}
+
+int HOCRPage::findWord(const QString& str, Qt::CaseSensitivity cs, int begin, int end, bool backwards) const {
+	const TextIndex& words = textIndex();
+	int count = words.offsets.size();
+	begin = std::max(begin, 0);
+	end = std::min(end, count);
+	if(begin >= end || str.isEmpty()) {
+		return -1;
+	}
+	// Searched range of the text, without the trailing separator
+	int first = words.offsets[begin];
+	int last = (end < count ? words.offsets[end] : words.text.size()) - 1;
+	if(last - str.length() < first) {
+		return -1;
+	}
+	int pos = backwards ? words.text.lastIndexOf(str, last - str.length(), cs) : words.text.indexOf(str, first, cs);
+	while(pos >= first && pos + str.length() <= last) {
+		int n = std::upper_bound(words.offsets.begin(), words.offsets.end(), pos) - words.offsets.begin() - 1;
+		int wordEnd = (n + 1 < count ? words.offsets[n + 1] : words.text.size()) - 1;
+		if(pos + str.length() <= wordEnd) {
+			return n;
+		}
+		if(backwards && pos == first) {
+			break;
+		}
+		pos = backwards ? words.text.lastIndexOf(str, pos - 1, cs) : words.text.indexOf(str, pos + 1, cs);
+	}
+	return -1;
+}
+
+HOCRItem* HOCRPage::word(int n) const {
+	const HOCRItem* result = nullptr;
+	visitItems(this, [&](const HOCRItem* item) {
+		if(item->itemClassId() == ItemClass::Word && n-- == 0) {
+			result = item;
+			return false;
+		}
+		return true;
+	});
+	return const_cast<HOCRItem*>(result);
+}
+
+int HOCRPage::wordsBefore(const HOCRItem* item) const {
+	int count = 0;
+	visitItems(this, [&](const HOCRItem* it) {
+		if(it == item) {
+			return false;
+		}
+		count += it->itemClassId() == ItemClass::Word ? 1 : 0;
+		return true;
+	});
+	return count;
+}
+
+QByteArray HOCRPage::serializeChildren() const {
+	HOCRBinaryWriter writer;
+	writer.stream() << quint32(m_childItems.size());
+	for(const HOCRItem* child : m_childItems) {
+		child->writeBinary(writer, true);
+	}
+	return writer.finish();
+}
+
+bool HOCRPage::evictChildren() {
+	if(m_childrenEvicted.loadAcquire() || m_modified) {
+		return false;
+	}
+	// The text index remains searchable while the page is evicted
+	textIndex();
+	QMutexLocker locker(&s_evictionMutex);
+	// Only the children are evicted, the page attributes remain accessible
+	m_evictedChildren = serializeChildren();
+	m_evictedChildCount = m_childItems.size();
+	m_childrenEvicted.storeRelease(1);
+	m_grid.reset();
+	qDeleteAll(m_childItems);
+	m_childItems.clear();
+	m_childItems.squeeze();
+	m_memoryCost = 0;
+	return true;
+}
+
+void HOCRPage::restoreEvictedChildren() {
+	QMutexLocker locker(&s_evictionMutex);
+	if(!m_childrenEvicted.loadAcquire()) {
+		return;
+	}
+	HOCRBinaryReader reader(m_evictedChildren);
+	readBinaryChildren(reader);
+	m_evictedChildren.clear();
+	m_evictedChildCount = 0;
+	m_modified = false;
+	m_childrenEvicted.storeRelease(0);
+}
+
+bool HOCRPage::detachEvictedChildren(QVector<HOCRItem*>& children) const {
+	QByteArray evictedChildren;
+	{
+		QMutexLocker locker(&s_evictionMutex);
+		if(!m_childrenEvicted.loadAcquire()) {
+			return false;
+		}
+		evictedChildren = m_evictedChildren;
+	}
+	HOCRBinaryReader reader(evictedChildren);
+	quint32 count = 0;
+	reader.stream() >> count;
+	HOCRPage* page = const_cast<HOCRPage*>(this);
+	for(quint32 i = 0; i < count && reader.ok(); ++i) {
+		HOCRItem* item = new HOCRItem(reader, page, page, i);
+		children.append(item);
+		item->readBinaryChildren(reader);
+	}
+	return true;
+}
+
+void HOCRPage::writeHtmlDetached(HOCRHtmlWriter& writer, int indent) const {
+	QVector<HOCRItem*> children;
+	if(!detachEvictedChildren(children)) {
+		writeHtml(writer, indent);
+		return;
+	}
+	writeHtml(writer, indent, children);
+	qDeleteAll(children);
 }
 
-QString HOCRPage::title() const {
-	return QString("%1 [%2]").arg(QFileInfo(m_sourceFile).fileName()).arg(m_pageNr);
+void HOCRPage::updateTitle() {
+	m_title = QString("%1 [%2]").arg(QFileInfo(m_sourceFile).fileName()).arg(m_pageNr);
 }
 
 void HOCRPage::convertSourcePath(const QString& basepath, bool absolute) {
@@ -1094,5 +3331,6 @@ void HOCRPage::convertSourcePath(const QString& basepath, bool absolute) {
 	} else if(!absolute && QFileInfo(m_sourceFile).isAbsolute() && m_sourceFile.startsWith(basepath)) {
 		m_sourceFile = QString("./%1").arg(QDir(basepath).relativeFilePath(m_sourceFile));
 	}
-	m_titleAttrs["image"] = QString("'%1'").arg(m_sourceFile);
+	setTitleAttribute("image", QString("'%1'").arg(m_sourceFile));
+	updateTitle();
 }
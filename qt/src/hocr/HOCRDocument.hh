@@ -22,9 +22,25 @@
 
 #include "Config.hh"
 #include <QAbstractItemModel>
+#include <QAtomicInt>
+#include <QHash>
+#include <QIcon>
+#include <QMutex>
+#include <QReadWriteLock>
 #include <QRect>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+#include <functional>
+#include <memory>
 
 class QDomElement;
+class QFile;
+class QIODevice;
+class QXmlStreamReader;
+class HOCRBinaryReader;
+class HOCRBinaryWriter;
+class HOCRHtmlWriter;
 class HOCRItem;
 class HOCRPage;
 class HOCRSpellChecker;
@@ -48,8 +64,64 @@ public:
 	void addWordToDictionary(const QModelIndex& index);
 
 	QString toHTML() const;
-
-	QModelIndex insertPage(int beforeIdx, const QDomElement& pageElement, bool cleanGraphics, const QString& sourceBasePath = QString());
+	// Serializes the pages to dev through a fixed size buffer, returns false on write errors
+	bool writeHTML(QIODevice* dev) const;
+	// Binary project files store the item trees with per-page offsets, the pages are
+	// loaded from the memory mapped file only when they are accessed
+	bool writeProject(QIODevice* dev) const;
+	bool readProject(const QString& filename, QVector<HOCRPage*>& pages, const QString& sourceBasePath);
+	bool readProject(const QByteArray& data, QVector<HOCRPage*>& pages, const QString& sourceBasePath);
+	static bool isProjectFile(const QString& filename);
+	// Copies the data of pages still backed by the mapping of the project file and unmaps it, so that the file can be replaced
+	void releaseProjectFile(const QString& filename);
+	// Self-contained binary serialization of a single page, in the format of the pages of project files
+	QByteArray serializePage(const HOCRPage* page) const;
+	HOCRPage* deserializePage(const QByteArray& data);
+	// Text, enabled state or attribute edit of a single item, which can be replayed on a copy of the page
+	struct ItemEdit {
+		enum Type : quint8 { Text = 1, Enabled, Attribute } type;
+		// Rows of the item and its ancestors, from the page down
+		QVector<int> path;
+		// Attribute name, empty for other edits
+		QString name;
+		// The text, the attribute value, or "1" / "0" for the enabled state
+		QString value;
+		QString attrItemClass;
+	};
+	// Applies an edit to a page which is not part of the document, i.e. while recovering it
+	bool applyItemEdit(HOCRPage* page, const ItemEdit& edit);
+	// Approximate memory used by page item trees before unmodified pages are evicted, 0 for no limit
+	void setMemoryCap(qint64 bytes);
+	// Eviction must be blocked while item pointers are held outside of the model, i.e. during exports
+	void blockEviction(bool block);
+	// Pinned pages are never evicted, for views holding item pointers of a page without persistent indices
+	void pinPage(int pageId, bool pin);
+	// Once the document was saved, modified pages can be evicted again
+	void clearModified();
+	// The dataChanged and itemAttributeChanged notifications of the edits between beginBulkEdit and the
+	// matching endBulkEdit are merged into one range per parent item and one change per attribute, and
+	// emitted by the outermost endBulkEdit. Row insertions and removals are still signalled immediately.
+	void beginBulkEdit();
+	void endBulkEdit();
+	class BulkEdit {
+	public:
+		BulkEdit(HOCRDocument* document) : m_document(document) {
+			m_document->beginBulkEdit();
+		}
+		~BulkEdit() {
+			m_document->endBulkEdit();
+		}
+	private:
+		HOCRDocument* m_document;
+	};
+
+	QModelIndex insertPage(int beforeIdx, const QDomElement& pageElement, bool cleanGraphics, const QList<Config::Lang>& langSpecs, const QString& sourceBasePath = QString());
+	void insertPages(int beforeIdx, const QVector<HOCRPage*>& pages);
+	// Builds the pages of a hOCR document directly from the data, without an intermediate DOM.
+	// Safe to call from a worker thread, given a copy of the language definitions taken on the GUI thread.
+	// progress is called with the number of bytes parsed so far, possibly from multiple threads, parsing
+	// is aborted if it returns false.
+	bool readPages(const QByteArray& data, QVector<HOCRPage*>& pages, const QString& sourceBasePath, const QList<Config::Lang>& langSpecs, const std::function<bool(qint64)>& progress = nullptr);
 	const HOCRPage* page(int i) const {
 		return m_pages.value(i);
 	}
@@ -70,11 +142,19 @@ public:
 	QModelIndex mergeItemText(const QModelIndex& itemIndex, bool mergeNext);
 	QModelIndex addItem(const QModelIndex& parent, const QDomElement& element);
 	bool removeItem(const QModelIndex& index);
+	// Passes the text of every word to edit in a single pass, only words whose text was changed are
+	// updated, with one notification per parent item. Returns the number of changed words.
+	int editWordTexts(const std::function<bool(QString&)>& edit);
+	// Replaces search in the text of all words, returns the number of changed words
+	int replaceWordTexts(const QString& search, const QString& replace, Qt::CaseSensitivity cs);
 
 	QModelIndex nextIndex(const QModelIndex& current) const;
 	QModelIndex prevIndex(const QModelIndex& current) const;
 	QModelIndex prevOrNextIndex(bool next, const QModelIndex& current, const QString& ocrClass, bool misspelled = false, bool lowconf = false) const;
 	bool indexIsMisspelledWord(const QModelIndex& index) const;
+	// Next (or previous) word containing str after from in document order, wrapping around at the end of the document.
+	// from itself is excluded. The page text indexes are searched, items are only visited for the result.
+	QModelIndex findWord(const QModelIndex& from, const QString& str, Qt::CaseSensitivity cs, bool backwards) const;
 	bool getItemSpellingSuggestions(const QModelIndex& index, QString& trimmedWord, QStringList& suggestions, int limit) const;
 
 	bool referencesSource(const QString& filename) const;
@@ -92,43 +172,200 @@ public:
 
 signals:
 	void itemAttributeChanged(const QModelIndex& itemIndex, const QString& name, const QString& value);
+	void spellCheckDone(int pageId, int generation);
+	// Emitted after every item edit, also within bulk edits. revision is the revision of the page before the edit,
+	// a page revision which changed otherwise indicates a modification which is not described by an edit.
+	void itemEdited(const HOCRPage* page, quint32 revision, const HOCRDocument::ItemEdit& edit);
 
 private:
-	int m_pageIdCounter = 0;
+	QAtomicInt m_pageIdCounter;
 	QString m_defaultLanguage = "en_US";
 	HOCRSpellChecker* m_spell;
+	// Enchant is not thread-safe, all dictionary access of both checkers is serialized
+	mutable QMutex m_dictMutex;
+
+	// Spelling results by (language, trimmed word), shared by the GUI thread and the background worker
+	mutable QHash<QPair<int, QString>, bool> m_spellCache;
+	mutable QMutex m_spellCacheMutex;
+	// Inserted pages are spell checked one at a time in the background, with a separate checker instance
+	HOCRSpellChecker* m_bgSpell;
+	QThreadPool m_spellPool;
+	QList<HOCRPage*> m_spellQueue;
+	// Pending pages which are evicted, queued again once restored
+	QSet<HOCRPage*> m_spellDeferred;
+	HOCRPage* m_spellPage = nullptr;
+	QAtomicInt m_spellGeneration;
+
+	qint64 m_memoryCap = 0;
+	int m_evictionBlocked = 0;
+	mutable QTimer m_evictTimer;
+	mutable quint64 m_useCounter = 0;
+	// Pin count by page id
+	QHash<int, int> m_pinnedPages;
+	// Backing storage of pages loaded from project files, mapped files with their data and project data in memory
+	QList<QPair<QFile*, QByteArray>> m_projectFiles;
+	QList<QByteArray> m_projectData;
 
 	QVector<HOCRPage*> m_pages;
+	// Lookup of the pages by source file and source page number, kept in sync with m_pages
+	QMultiHash<QPair<QString, int>, HOCRPage*> m_sourcePages;
+	QHash<QString, int> m_sourceRefCount;
+
+	struct PendingChange {
+		QPersistentModelIndex parent;
+		bool topLevel;
+		QPersistentModelIndex first;
+		QPersistentModelIndex last;
+		int firstColumn;
+		int lastColumn;
+		QVector<int> roles;
+	};
+	struct PendingAttributeChange {
+		QPersistentModelIndex index;
+		QString name;
+		QString value;
+	};
+	int m_bulkEditDepth = 0;
+	// Keyed by the internal pointer of the parent and of the item respectively
+	QVector<PendingChange> m_pendingChanges;
+	QHash<const void*, int> m_pendingChangeIds;
+	QVector<PendingAttributeChange> m_pendingAttributeChanges;
+	QHash<QPair<const void*, QString>, int> m_pendingAttributeChangeIds;
+
+	// Shared by all items of a class, the views query them for every visible row while scrolling
+	QVector<QIcon> m_classIcons;
+	QVector<QString> m_classLabels;
 
 	QString displayRoleForItem(const HOCRItem* item) const;
 	QIcon decorationRoleForItem(const HOCRItem* item) const;
 	QString tooltipRoleForItem(const HOCRItem* item) const;
 
+	void notifyDataChanged(const QModelIndex& first, const QModelIndex& last, const QVector<int>& roles);
+	void notifyItemAttributeChanged(const QModelIndex& index, const QString& name, const QString& value);
 	void insertItem(HOCRItem* parent, HOCRItem* item, int i);
 	void deleteItem(HOCRItem* item);
 	void takeItem(HOCRItem* item);
 	void resetMisspelled(const QModelIndex& index);
 	QList<QModelIndex> recheckItemSpelling(const QModelIndex& index) const;
+	bool checkSpelling(int langId, const QString& word) const;
+	void ignoreSpelling(const QString& word);
+	void queueSpellCheck(HOCRPage* page);
+	void unqueueSpellCheck(HOCRPage* page);
+	void deferSpellCheck(HOCRPage* page);
+	void resumeSpellCheck(HOCRPage* page);
+	void startSpellCheck();
+	void spellCheckFinished(int pageId, int generation);
+	void collectSpellCheckWords(const HOCRItem* item, QSet<QPair<int, QString>>& words) const;
+	void applySpellCheck(const QModelIndex& index);
+	const QVector<int>& misspelledWords(const HOCRPage* page) const;
+	QModelIndex searchWords(const QModelIndex& from, bool backwards, const std::function<int(const HOCRPage*, int, int)>& pageSearch) const;
 	void recomputeBBoxes(HOCRItem* item);
+	void emitItemEdited(const HOCRItem* item, quint32 revision, ItemEdit::Type type, const QString& value, const QString& name = QString(), const QString& attrItemClass = QString());
+	int editWordTexts(const QModelIndex& parent, const std::function<bool(QString&)>& edit);
+	void indexPage(HOCRPage* page);
+	void unindexPage(HOCRPage* page);
+	void evictPages();
+	QSet<const HOCRPage*> pinnedPages() const;
+	int evictPageChildren(const QVector<HOCRPage*>& pages);
+	static bool seekFirstPage(QXmlStreamReader& reader);
+	static QVector<QPair<int, int>> splitPages(const QByteArray& data);
+	bool readPagesConcurrent(const QByteArray& data, const QVector<QPair<int, int>>& ranges, QVector<HOCRPage*>& pages, const QString& sourceBasePath, const QList<Config::Lang>& langSpecs, const std::function<bool(qint64)>& progress);
+	bool readPagesSequential(const QByteArray& data, QVector<HOCRPage*>& pages, const QString& sourceBasePath, const QList<Config::Lang>& langSpecs, const std::function<bool(qint64)>& progress);
 	HOCRItem* mutableItemAtIndex(const QModelIndex& index) const {
 		return index.isValid() ? static_cast<HOCRItem*>(index.internalPointer()) : nullptr;
 	}
 };
 
 
+// Compact storage for the attributes of an item: a flat list of name-value pairs.
+// Attribute names are interned and stored as ids, the values of attributes which
+// typically repeat across items (languages, fonts, ...) are interned as well so
+// that all items share the same string data.
+class HOCRAttributes {
+public:
+	QString value(const QString& name) const {
+		int idx = find(name);
+		return idx >= 0 ? m_entries[idx].second : QString();
+	}
+	bool contains(const QString& name) const {
+		return find(name) >= 0;
+	}
+	bool isEmpty() const {
+		return m_entries.isEmpty();
+	}
+	int size() const {
+		return m_entries.size();
+	}
+	void insert(const QString& name, const QString& value);
+	void remove(const QString& name);
+	void addToMap(QMap<QString, QString>& map, const QString& prefix = QString()) const;
+	QString nameAt(int i) const {
+		return name(m_entries[i].first);
+	}
+	const QString& valueAt(int i) const {
+		return m_entries[i].second;
+	}
+	void writeBinary(HOCRBinaryWriter& writer) const;
+	void readBinary(HOCRBinaryReader& reader);
+
+	static QString intern(const QString& string);
+
+private:
+	QVector<QPair<quint16, QString>> m_entries;
+
+	int find(const QString& name) const;
+	static int lookupNameId(const QString& name);
+	static quint16 nameId(const QString& name);
+	static QString name(quint16 id);
+};
+
+// Interned value of the lang attribute of items, shared by all items with the same
+// language. Instances are never freed, items reference them and compare them by id.
+// The lang attribute of words is the dictionary language, element languages are resolved
+// to it once when parsing (see HOCRItem::itemLanguage).
+class HOCRLanguage {
+public:
+	int id() const {
+		return m_id;
+	}
+	const QString& lang() const {
+		return m_lang;
+	}
+
+	// Ids start at 1, an empty language is represented by nullptr
+	static const HOCRLanguage* intern(const QString& lang);
+	static const HOCRLanguage* fromId(int id);
+
+private:
+	int m_id;
+	QString m_lang;
+
+	HOCRLanguage(int id, const QString& lang) : m_id(id), m_lang(lang) {}
+};
+
+
 class HOCRItem {
 public:
 	// attrname : attrvalue : occurrences
 	typedef QMap<QString, QMap<QString, int>> AttrOccurenceMap_t;
 
+	enum class ItemClass : quint8 { Page, CArea, Par, Line, Word, Graphic, Other };
+
 	HOCRItem(const QDomElement& element, HOCRPage* page, HOCRItem* parent, int index = -1);
+	HOCRItem(QXmlStreamReader& reader, HOCRPage* page, HOCRItem* parent, int index = -1);
+	HOCRItem(HOCRBinaryReader& reader, HOCRPage* page, HOCRItem* parent, int index = -1);
 	virtual ~HOCRItem();
 	HOCRPage* page() const {
 		return m_pageItem;
 	}
 	const QVector<HOCRItem*>& children() const {
+		if(m_childrenEvicted.loadAcquire()) {
+			restoreChildren();
+		}
 		return m_childItems;
 	}
+	// Number of children, without restoring evicted children
+	int childCount() const;
 	HOCRItem* parent() const {
 		return m_parentItem;
 	}
@@ -140,9 +377,10 @@ public:
 	}
 
 	// HOCR specific convenience getters
-	QString itemClass() const {
-		return m_attrs["class"];
+	ItemClass itemClassId() const {
+		return m_class;
 	}
+	QString itemClass() const;
 	const QRect& bbox() const {
 		return m_bbox;
 	}
@@ -150,29 +388,32 @@ public:
 		return m_text;
 	}
 	QString lang() const {
-		return m_attrs["lang"];
-	}
-	QString spellingLang() const {
-		QString l = lang();
-		QString code = Config::lookupLangCode(l);
-		return code.isEmpty() ? l : code;
-	}
-	const QMap<QString, QString> getAttributes() const {
-		return m_attrs;
+		return m_lang ? m_lang->lang() : QString();
 	}
-	const QMap<QString, QString> getTitleAttributes() const {
-		return m_titleAttrs;
+	int langId() const {
+		return m_lang ? m_lang->id() : 0;
 	}
+	QString attribute(const QString& name) const;
+	QString titleAttribute(const QString& name) const;
+	QMap<QString, QString> getAttributes() const;
+	QMap<QString, QString> getTitleAttributes() const;
 	QMap<QString, QString> getAllAttributes() const;
 	QMap<QString, QString> getAttributes(const QList<QString>& names) const;
 	void getPropagatableAttributes(QMap<QString, QMap<QString, QSet<QString> > >& occurrences) const;
 	QString toHtml(int indent = 0) const;
+	void writeHtml(HOCRHtmlWriter& writer, int indent = 0) const {
+		writeHtml(writer, indent, children());
+	}
+	void writeBinary(HOCRBinaryWriter& writer, bool recursive) const;
 	QPair<double, double> baseLine() const;
+	int wordConfidence() const {
+		return (m_nativeAttrs & HasWConf) ? m_wconf : m_titleAttrs.value("x_wconf").toInt();
+	}
 	QString fontFamily() const {
-		return m_titleAttrs["x_font"];
+		return m_titleAttrs.value("x_font");
 	}
 	double fontSize() const {
-		return m_titleAttrs["x_fsize"].toDouble();
+		return (m_nativeAttrs & HasFSize) ? m_fsize : m_titleAttrs.value("x_fsize").toDouble();
 	}
 	bool fontBold() const {
 		return m_bold;
@@ -184,27 +425,45 @@ public:
 	static QMap<QString, QString> deserializeAttrGroup(const QString& string);
 	static QString serializeAttrGroup(const QMap<QString, QString>& attrs);
 	static QString trimmedWord(const QString& word, QString* prefix = nullptr, QString* suffix = nullptr);
+	static ItemClass itemClassFromName(const QString& name);
 
 protected:
 	friend class HOCRDocument;
 	friend class HOCRPage;
 
+	// Title attributes which are stored parsed rather than in m_titleAttrs
+	enum NativeAttr : quint8 { HasBBox = 1, HasBaseline = 2, HasWConf = 4, HasFSize = 8 };
+
 	static QMap<QString, QString> s_langCache;
+	static QReadWriteLock s_langCacheLock;
 
 	QString m_text;
-	int m_misspelled = -1;
-	bool m_bold;
-	bool m_italic;
-
-	QMap<QString, QString> m_attrs;
-	QMap<QString, QString> m_titleAttrs;
+	ItemClass m_class = ItemClass::Other;
+	ItemClass m_idClass = ItemClass::Other;
+	quint8 m_nativeAttrs = 0;
+	qint8 m_misspelled = -1;
+	bool m_bold = false;
+	bool m_italic = false;
+	bool m_enabled = true;
+	// Set once the children of the page were evicted, read without locking by the view and export threads
+	QAtomicInteger<quint8> m_childrenEvicted = 0;
+
+	// If non-zero, the id is <class>_<pageId>_<counter>, generated on demand
+	int m_idCounter = 0;
+	int m_idPageId = 0;
+	HOCRAttributes m_attrs;
+	HOCRAttributes m_titleAttrs;
+	// Cached from the lang attribute
+	const HOCRLanguage* m_lang = nullptr;
 	QVector<HOCRItem*> m_childItems;
 	HOCRPage* m_pageItem = nullptr;
 	HOCRItem* m_parentItem = nullptr;
 	int m_index;
-	bool m_enabled = true;
 
 	QRect m_bbox;
+	float m_baseline[2] = {0.f, 0.f};
+	float m_fsize = 0.f;
+	int m_wconf = 0;
 
 	// All mutations must be done through methods of HOCRDocument
 	void addChild(HOCRItem* child);
@@ -212,26 +471,38 @@ protected:
 	void removeChild(HOCRItem* child);
 	void takeChild(HOCRItem* child);
 	QVector<HOCRItem*> takeChildren();
-	void setEnabled(bool enabled) {
-		m_enabled = enabled;
-	}
-	void setText(const QString& newText) {
-		m_text = newText;
-	}
-	void setMisspelled(int misspelled) {
-		m_misspelled = misspelled;
-	}
+	void setPage(HOCRPage* page);
+	void setEnabled(bool enabled);
+	void setText(const QString& newText);
+	void setMisspelled(int misspelled);
 	int isMisspelled() const {
 		return m_misspelled;
 	}
 	void setAttribute(const QString& name, const QString& value, const QString& attrItemClass = QString());
-	bool parseChildren(const QDomElement& element, QString language, const QString& defaultLanguage);
+	void setPlainAttribute(const QString& name, const QString& value);
+	void setTitleAttribute(const QString& name, const QString& value);
+	void setTitleAttribute(QStringView name, QStringView value);
+	void parseTitleAttributes(QStringView title);
+	void writeAttributes(HOCRHtmlWriter& writer) const;
+	void writeTitleAttributes(HOCRHtmlWriter& writer) const;
+	void removeTitleAttribute(const QString& name);
+	void initAttributes();
+	QString itemLanguage(const QString& elemLang, const QString& language, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs);
+	bool parseChildren(const QDomElement& element, QString language, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs);
+	bool parseChildren(QXmlStreamReader& reader, QString language, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs);
+	bool readBinaryChildren(HOCRBinaryReader& reader);
+	void writeHtml(HOCRHtmlWriter& writer, int indent, const QVector<HOCRItem*>& children) const;
+	void restoreChildren() const;
+	void setModified();
+	qint64 memoryCost() const;
 };
 
 
 class HOCRPage : public HOCRItem {
 public:
-	HOCRPage(const QDomElement& element, int pageId, const QString& defaultLanguage, bool cleanGraphics, int index);
+	HOCRPage(const QDomElement& element, int pageId, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs, bool cleanGraphics, int index);
+	HOCRPage(QXmlStreamReader& reader, int pageId, const QString& defaultLanguage, const QList<Config::Lang>& langSpecs, bool cleanGraphics, int index);
+	HOCRPage(HOCRBinaryReader& reader, int pageId, int index);
 
 	const QString& sourceFile() const {
 		return m_sourceFile;
@@ -249,20 +520,87 @@ public:
 	int pageId() const {
 		return m_pageId;
 	}
-	QString title() const;
+	const QString& title() const {
+		return m_title;
+	}
+
+	// Items of the page (excluding the page itself) whose bbox contains pos / intersects rect
+	QVector<HOCRItem*> itemsAt(const QPoint& pos) const;
+	QVector<HOCRItem*> itemsInRect(const QRect& rect) const;
+
+	bool isEvicted() const {
+		return m_childrenEvicted.loadAcquire();
+	}
+	// As writeHtml, but evicted children are written from a temporary copy instead of being restored
+	void writeHtmlDetached(HOCRHtmlWriter& writer, int indent = 0) const;
+	// Incremented by every modification of the page or its items
+	quint32 revision() const {
+		return m_revision;
+	}
 
 private:
 	friend class HOCRItem;
 	friend class HOCRDocument;
 
+	// Uniform grid over the item bboxes, built on the first query and kept up to date
+	// by the HOCRItem mutators afterwards
+	struct SpatialGrid {
+		QRect rect;
+		int cellSize;
+		int cols;
+		int rows;
+		QVector<QVector<HOCRItem*>> cells;
+		QHash<const HOCRItem*, QRect> itemRects;
+	};
+	mutable std::unique_ptr<SpatialGrid> m_grid;
+	// Texts of the words of the page in document order, joined in a single string which can be searched
+	// without walking the item tree. Built on demand, dropped on modification and kept on eviction.
+	struct TextIndex {
+		QString text;
+		QVector<int> offsets; // Start of each word in text
+		QVector<int> lowConfidence; // Sorted numbers of the words below the confidence threshold
+	};
+	mutable std::unique_ptr<TextIndex> m_textIndex;
+	// Sorted numbers of the misspelled words, built on demand by the document and dropped
+	// when the spelling state of a word changes or the page is modified
+	mutable std::unique_ptr<QVector<int>> m_misspelledWords;
+
 	int m_pageId;
+	bool m_spellCheckPending = false;
+	// Unmodified pages may have their item tree evicted to its binary serialization
+	// under memory pressure, it is transparently restored on the next access
+	bool m_modified = false;
+	quint32 m_revision = 0;
+	int m_evictedChildCount = 0;
+	QByteArray m_evictedChildren;
+	mutable qint64 m_memoryCost = 0;
+	mutable quint64 m_lastUsed = 0;
 	QMap<QString, int> m_idCounters;
 	QString m_sourceFile;
+	QString m_title;
 	int m_pageNr;
 	double m_angle;
 	int m_resolution;
 
+	void initPage();
+	void checkGraphic(HOCRItem* item, bool haveWords, bool cleanGraphics);
 	void convertSourcePath(const QString& basepath, bool absolute);
+	void updateTitle();
+	QByteArray serializeChildren() const;
+	bool evictChildren();
+	void restoreEvictedChildren();
+	// Deserializes a copy of the evicted children, which the caller owns, and leaves the page evicted.
+	// Returns false if the page is not evicted.
+	bool detachEvictedChildren(QVector<HOCRItem*>& children) const;
+	void buildGrid() const;
+	QRect gridCells(const QRect& rect) const;
+	void gridInsert(HOCRItem* item, bool recursive) const;
+	void gridRemove(const HOCRItem* item, bool recursive) const;
+	void gridUpdate(HOCRItem* item) const;
+	const TextIndex& textIndex() const;
+	int findWord(const QString& str, Qt::CaseSensitivity cs, int begin, int end, bool backwards) const;
+	HOCRItem* word(int n) const;
+	int wordsBefore(const HOCRItem* item) const;
 };
 
 
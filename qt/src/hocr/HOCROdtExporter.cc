@@ -256,7 +256,7 @@ void HOCROdtExporter::writeImage(QuaZip& zip, QMap<const HOCRItem*, QString>& im
 	if(!item->isEnabled()) {
 		return;
 	}
-	if(item->itemClass() == "ocr_graphic") {
+	if(item->itemClassId() == HOCRItem::ItemClass::Graphic) {
 		QImage image;
 		QMetaObject::invokeMethod(this, "getSelection",  Qt::BlockingQueuedConnection, Q_RETURN_ARG(QImage, image), Q_ARG(QRect, item->bbox()));
 		QString filename = QString("Pictures/%1.png").arg(QUuid::createUuid().toString());
@@ -272,7 +272,7 @@ void HOCROdtExporter::writeFontFaceDecls(QSet<QString>& families, const HOCRItem
 	if(!item->isEnabled()) {
 		return;
 	}
-	if(item->itemClass() == "ocrx_word") {
+	if(item->itemClassId() == HOCRItem::ItemClass::Word) {
 		QString fontFamily = item->fontFamily();
 		if(!families.contains(fontFamily)) {
 			if(!fontFamily.isEmpty()) {
@@ -293,7 +293,7 @@ void HOCROdtExporter::writeFontStyles(QMap<QString, QMap<double, QString>>& styl
 	if(!item->isEnabled()) {
 		return;
 	}
-	if(item->itemClass() == "ocrx_word") {
+	if(item->itemClassId() == HOCRItem::ItemClass::Word) {
 		QString fontKey = item->fontFamily() + (item->fontBold() ? "@bold" : "") + (item->fontItalic() ? "@italic" : "");
 		if(!styles.contains(fontKey) || !styles[fontKey].contains(item->fontSize())) {
 			QString styleName = QString("T%1").arg(++counter);
@@ -325,9 +325,9 @@ void HOCROdtExporter::printItem(QXmlStreamWriter& writer, const HOCRItem* item,
 	if(!item->isEnabled()) {
 		return;
 	}
-	QString itemClass = item->itemClass();
+	HOCRItem::ItemClass itemClass = item->itemClassId();
 	const QRect& bbox = item->bbox();
-	if(itemClass == "ocr_graphic") {
+	if(itemClass == HOCRItem::ItemClass::Graphic) {
 		writer.writeStartElement(drawNS, "frame");
 		writer.writeAttribute(drawNS, "style-name", "F");
 		writer.writeAttribute(textNS, "anchor-type", "page");
@@ -345,7 +345,7 @@ void HOCROdtExporter::printItem(QXmlStreamWriter& writer, const HOCRItem* item,
 		writer.writeEndElement(); // image
 
 		writer.writeEndElement(); // frame
-	} else if(itemClass == "ocr_par") {
+	} else if(itemClass == HOCRItem::ItemClass::Par) {
 		writer.writeStartElement(drawNS, "frame");
 		writer.writeAttribute(drawNS, "style-name", "F");
 		writer.writeAttribute(textNS, "anchor-type", "page");
@@ -367,7 +367,7 @@ void HOCROdtExporter::printItem(QXmlStreamWriter& writer, const HOCRItem* item,
 
 		writer.writeEndElement(); // text-box
 		writer.writeEndElement(); // frame
-	} else if(itemClass == "ocr_line") {
+	} else if(itemClass == HOCRItem::ItemClass::Line) {
 		const HOCRItem* firstWord = nullptr;
 		int iChild = 0, nChilds = item->children().size();
 		for(; iChild < nChilds; ++iChild) {
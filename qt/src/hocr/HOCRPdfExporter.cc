@@ -161,10 +161,10 @@ void HOCRPdfPrinter::printChildren(const HOCRItem* item, const HOCRPdfExporter::
 	if(pdfSettings.fontSize != -1) {
 		setFontSize(pdfSettings.fontSize * fontScale);
 	}
-	QString itemClass = item->itemClass();
+	HOCRItem::ItemClass itemClass = item->itemClassId();
 	QRect itemRect = item->bbox();
 	int childCount = item->children().size();
-	if(itemClass == "ocr_par" && pdfSettings.uniformizeLineSpacing) {
+	if(itemClass == HOCRItem::ItemClass::Par && pdfSettings.uniformizeLineSpacing) {
 		double yInc = double(itemRect.height()) / childCount;
 		double y = itemRect.top() + yInc;
 		QPair<double, double> baseline = childCount > 0 ? item->children()[0]->baseLine() : qMakePair(0.0, 0.0);
@@ -196,7 +196,7 @@ void HOCRPdfPrinter::printChildren(const HOCRItem* item, const HOCRPdfExporter::
 				x += getTextWidth(text + " ") / px2pu;
 			}
 		}
-	} else if(itemClass == "ocr_line" && !pdfSettings.uniformizeLineSpacing) {
+	} else if(itemClass == HOCRItem::ItemClass::Line && !pdfSettings.uniformizeLineSpacing) {
 		QPair<double, double> baseline = item->baseLine();
 		for(int iWord = 0, nWords = item->children().size(); iWord < nWords; ++iWord) {
 			HOCRItem* wordItem = item->children()[iWord];
@@ -215,7 +215,7 @@ void HOCRPdfPrinter::printChildren(const HOCRItem* item, const HOCRPdfExporter::
 			}
 			drawText(wordRect.x() * px2pu, y * px2pu, text);
 		}
-	} else if(itemClass == "ocr_graphic" && !pdfSettings.overlay) {
+	} else if(itemClass == HOCRItem::ItemClass::Graphic && !pdfSettings.overlay) {
 		QRect scaledItemRect(itemRect.left() * imgScale, itemRect.top() * imgScale, itemRect.width() * imgScale, itemRect.height() * imgScale);
 		QRect printRect(itemRect.left() * px2pu, itemRect.top() * px2pu, itemRect.width() * px2pu, itemRect.height() * px2pu);
 		QImage selection;
@@ -34,28 +34,56 @@
 
 class HOCRProofReadWidget::LineEdit : public QLineEdit {
 public:
-	LineEdit(HOCRProofReadWidget* proofReadWidget, HOCRItem* wordItem, QWidget* parent = nullptr) :
-		QLineEdit(wordItem->text(), parent), m_proofReadWidget(proofReadWidget), m_wordItem(wordItem) {
+	LineEdit(HOCRProofReadWidget* proofReadWidget, QWidget* parent = nullptr) :
+		QLineEdit(parent), m_proofReadWidget(proofReadWidget) {
 		connect(this, &LineEdit::textChanged, this, &LineEdit::onTextChanged);
-
-		HOCRDocument* document = static_cast<HOCRDocument*>(m_proofReadWidget->documentTree()->model());
-		connect(document, &HOCRDocument::dataChanged, this, &LineEdit::onModelDataChanged);
-		connect(document, &HOCRDocument::itemAttributeChanged, this, &LineEdit::onAttributeChanged);
-
-		QModelIndex index = document->indexAtItem(m_wordItem);
-		setStyleSheet( getStyle( document->indexIsMisspelledWord(index) ) );
-
-		QFont ft = font();
-		ft.setBold(m_wordItem->fontBold());
-		ft.setItalic(m_wordItem->fontItalic());
-		setFont(ft);
 	}
 	const HOCRItem* item() const { return m_wordItem; }
+	// Line edits are recycled, a null item detaches the line edit from the document
+	void setWordItem(HOCRItem* wordItem) {
+		if(m_wordItem) {
+			m_proofReadWidget->m_wordEdits.remove(m_wordItem);
+		}
+		m_wordItem = wordItem;
+		if(!m_wordItem) {
+			return;
+		}
+		m_proofReadWidget->m_wordEdits.insert(m_wordItem, this);
+		HOCRDocument* document = static_cast<HOCRDocument*>(m_proofReadWidget->documentTree()->model());
+		QSignalBlocker blocker(this);
+		setText(m_wordItem->text());
+		setMisspelled(document->indexIsMisspelledWord(document->indexAtItem(m_wordItem)));
+		updateFontStyle();
+	}
+	void modelDataChanged(const QVector<int>& roles) {
+		if(roles.contains(Qt::DisplayRole) && !m_blockSetText) {
+			QSignalBlocker blocker(this);
+			setText(m_wordItem->text());
+		}
+		if(roles.contains(Qt::ForegroundRole)) {
+			HOCRDocument* document = static_cast<HOCRDocument*>(m_proofReadWidget->documentTree()->model());
+			setMisspelled(document->indexIsMisspelledWord(document->indexAtItem(m_wordItem)));
+		}
+	}
+	void attributeChanged(const QString& name) {
+		if(name == "bold" || name == "italic") {
+			updateFontStyle();
+		} else if(name == "title:bbox") {
+			QPoint sceneCorner = MAIN->getDisplayer()->getSceneBoundingRect().toRect().topLeft();
+			QRect sceneBBox = m_wordItem->bbox().translated(sceneCorner);
+			QPoint bottomLeft = MAIN->getDisplayer()->mapFromScene(sceneBBox.bottomLeft());
+			QPoint bottomRight = MAIN->getDisplayer()->mapFromScene(sceneBBox.bottomRight());
+			int frameX = parentWidget()->parentWidget()->parentWidget()->pos().x();
+			move(bottomLeft.x() - frameX, 0);
+			setFixedWidth(bottomRight.x() - bottomLeft.x() + 8); // 8: border + padding
+		}
+	}
 
 private:
 	HOCRProofReadWidget* m_proofReadWidget = nullptr;
 	HOCRItem* m_wordItem = nullptr;
 	bool m_blockSetText = false;
+	bool m_misspelled = false;
 
 	QString getStyle(bool misspelled) const {
 		QStringList styles;
@@ -64,6 +92,21 @@ private:
 		}
 		return styles.isEmpty() ? "" : QString("QLineEdit {%1}").arg(styles.join(" "));
 	}
+	// Style sheets and fonts are only set if they change, both trigger a relayout of the line edit
+	void setMisspelled(bool misspelled) {
+		if(misspelled != m_misspelled) {
+			m_misspelled = misspelled;
+			setStyleSheet( getStyle( misspelled ) );
+		}
+	}
+	void updateFontStyle() {
+		QFont ft = font();
+		if(ft.bold() != m_wordItem->fontBold() || ft.italic() != m_wordItem->fontItalic()) {
+			ft.setBold(m_wordItem->fontBold());
+			ft.setItalic(m_wordItem->fontItalic());
+			setFont(ft);
+		}
+	}
 
 	void onTextChanged() {
 		HOCRDocument* document = static_cast<HOCRDocument*>(m_proofReadWidget->documentTree()->model());
@@ -74,38 +117,6 @@ private:
 		document->setData(index, text(), Qt::EditRole);
 		m_blockSetText = false;
 	}
-	void onModelDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles) {
-		HOCRDocument* document = static_cast<HOCRDocument*>(m_proofReadWidget->documentTree()->model());
-		QItemSelectionRange range(topLeft, bottomRight);
-		QModelIndex index = document->indexAtItem(m_wordItem);
-		if(range.contains(index)) {
-			if(roles.contains(Qt::DisplayRole) && !m_blockSetText) {
-				setText(m_wordItem->text());
-			}
-			if(roles.contains(Qt::ForegroundRole)) {
-				setStyleSheet( getStyle( document->indexIsMisspelledWord(index) ) );
-			}
-		}
-	}
-	void onAttributeChanged(const QModelIndex& index, const QString& name, const QString& /*value*/) {
-		HOCRDocument* document = static_cast<HOCRDocument*>(m_proofReadWidget->documentTree()->model());
-		if(document->itemAtIndex(index) == m_wordItem) {
-			if(name == "bold" || name == "italic") {
-				QFont ft = font();
-				ft.setBold(m_wordItem->fontBold());
-				ft.setItalic(m_wordItem->fontItalic());
-				setFont(ft);
-			} else if(name == "title:bbox") {
-				QPoint sceneCorner = MAIN->getDisplayer()->getSceneBoundingRect().toRect().topLeft();
-				QRect sceneBBox = m_wordItem->bbox().translated(sceneCorner);
-				QPoint bottomLeft = MAIN->getDisplayer()->mapFromScene(sceneBBox.bottomLeft());
-				QPoint bottomRight = MAIN->getDisplayer()->mapFromScene(sceneBBox.bottomRight());
-				int frameX = parentWidget()->parentWidget()->parentWidget()->pos().x();
-				move(bottomLeft.x() - frameX, 0);
-				setFixedWidth(bottomRight.x() - bottomLeft.x() + 8); // 8: border + padding
-			}
-		}
-	}
 	void keyPressEvent(QKeyEvent* ev) override {
 		HOCRDocument* document = static_cast<HOCRDocument*>(m_proofReadWidget->documentTree()->model());
 
@@ -186,9 +197,13 @@ private:
 		}
 	}
 	void focusInEvent(QFocusEvent* ev) override {
+		if(!m_wordItem) {
+			QLineEdit::focusInEvent(ev);
+			return;
+		}
 		HOCRDocument* document = static_cast<HOCRDocument*>(m_proofReadWidget->documentTree()->model());
 		m_proofReadWidget->documentTree()->setCurrentIndex(document->indexAtItem(m_wordItem));
-		m_proofReadWidget->setConfidenceLabel(m_wordItem->getTitleAttributes()["x_wconf"].toInt());
+		m_proofReadWidget->setConfidenceLabel(m_wordItem->wordConfidence());
 		QLineEdit::focusInEvent(ev);
 		if(ev->reason() != Qt::MouseFocusReason) {
 			deselect();
@@ -197,6 +212,37 @@ private:
 	}
 };
 
+// The words of a line, the line edits are reused when the widget shows another line
+class HOCRProofReadWidget::LineWidget : public QWidget {
+public:
+	LineWidget(HOCRProofReadWidget* proofReadWidget) : m_proofReadWidget(proofReadWidget) {}
+	const HOCRItem* line() const { return m_line; }
+	const QVector<LineEdit*>& lineEdits() const { return m_lineEdits; }
+	void setLine(const HOCRItem* line) {
+		m_line = line;
+		int nWords = line ? line->children().size() : 0;
+		while(m_lineEdits.size() > nWords) {
+			LineEdit* lineEdit = m_lineEdits.takeLast();
+			lineEdit->setWordItem(nullptr);
+			lineEdit->hide();
+			m_spareLineEdits.append(lineEdit);
+		}
+		while(m_lineEdits.size() < nWords) {
+			m_lineEdits.append(m_spareLineEdits.isEmpty() ? new LineEdit(m_proofReadWidget, this) : m_spareLineEdits.takeLast());
+		}
+		for(int i = 0; i < nWords; ++i) {
+			m_lineEdits[i]->setWordItem(line->children()[i]);
+			m_lineEdits[i]->show();
+		}
+	}
+
+private:
+	HOCRProofReadWidget* m_proofReadWidget;
+	const HOCRItem* m_line = nullptr;
+	QVector<LineEdit*> m_lineEdits;
+	QVector<LineEdit*> m_spareLineEdits;
+};
+
 
 HOCRProofReadWidget::HOCRProofReadWidget(QTreeView* treeView, QWidget* parent)
 	: QFrame(parent), m_treeView(treeView) {
@@ -280,6 +326,9 @@ HOCRProofReadWidget::HOCRProofReadWidget(QTreeView* treeView, QWidget* parent)
 
 	HOCRDocument* document = static_cast<HOCRDocument*>(m_treeView->model());
 
+	connect(document, &HOCRDocument::dataChanged, this, &HOCRProofReadWidget::onModelDataChanged);
+	connect(document, &HOCRDocument::itemAttributeChanged, this, &HOCRProofReadWidget::onAttributeChanged);
+
 	// Clear for rebuild if structure changes
 	connect(document, &HOCRDocument::rowsAboutToBeRemoved, this, &HOCRProofReadWidget::clear);
 	connect(document, &HOCRDocument::rowsAboutToBeInserted, this, &HOCRProofReadWidget::clear);
@@ -308,10 +357,30 @@ void HOCRProofReadWidget::setProofreadEnabled(bool enabled) {
 	}
 }
 
+void HOCRProofReadWidget::pinPage(const HOCRPage* page) {
+	// The line widgets hold item pointers of the page, which must not be evicted while they are shown
+	int pageId = page ? page->pageId() : -1;
+	if(pageId == m_pinnedPageId) {
+		return;
+	}
+	HOCRDocument* document = static_cast<HOCRDocument*>(m_treeView->model());
+	if(m_pinnedPageId != -1) {
+		document->pinPage(m_pinnedPageId, false);
+	}
+	if(pageId != -1) {
+		document->pinPage(pageId, true);
+	}
+	m_pinnedPageId = pageId;
+}
+
 void HOCRProofReadWidget::clear() {
-	qDeleteAll(m_currentLines);
+	// The widgets are kept for reuse, the items they reference may be about to be removed
+	for(LineWidget* lineWidget : m_currentLines) {
+		recycleLineWidget(lineWidget);
+	}
 	m_currentLines.clear();
 	m_currentLine = nullptr;
+	pinPage(nullptr);
 	m_confidenceLabel->setText("");
 	m_confidenceLabel->setStyleSheet("");
 	hide();
@@ -335,10 +404,10 @@ void HOCRProofReadWidget::updateWidget(bool force) {
 	}
 	const HOCRItem* lineItem = nullptr;
 	const HOCRItem* wordItem = nullptr;
-	if(item->itemClass() == "ocrx_word") {
+	if(item->itemClassId() == HOCRItem::ItemClass::Word) {
 		lineItem = item->parent();
 		wordItem = item;
-	} else if(item->itemClass() == "ocr_line") {
+	} else if(item->itemClassId() == HOCRItem::ItemClass::Line) {
 		lineItem = item;
 	} else {
 		clear();
@@ -347,38 +416,74 @@ void HOCRProofReadWidget::updateWidget(bool force) {
 
 	const QVector<HOCRItem*>& siblings = lineItem->parent()->children();
 	int targetLine = lineItem->index();
+	int firstLine = qMax(0, targetLine - nrLinesBefore);
+	int lastLine = qMin(siblings.size() - 1, targetLine + nrLinesAfter);
 	if(lineItem != m_currentLine || force) {
-		// Rebuild widget
-		QMap<const HOCRItem*, QWidget*> newLines;
-		int insPos = 0;
-		for(int i = qMax(0, targetLine - nrLinesBefore), j = qMin(siblings.size() - 1, targetLine + nrLinesAfter); i <= j; ++i) {
-			HOCRItem* linei = siblings[i];
-			if(m_currentLines.contains(linei)) {
-				newLines[linei] = m_currentLines.take(linei);
-				insPos = m_linesLayout->indexOf(newLines[linei]) + 1;
-			} else {
-				QWidget* lineWidget = new QWidget();
-				for(HOCRItem* word : siblings[i]->children()) {
-					new LineEdit(this, word, lineWidget); // Add as child to lineWidget
-				}
-				m_linesLayout->insertWidget(insPos++, lineWidget);
-				newLines.insert(linei, lineWidget);
+		// Lines which remain in the window keep their widgets, so moving to the next line only updates one widget
+		QHash<const HOCRItem*, LineWidget*> oldLines;
+		for(LineWidget* lineWidget : m_currentLines) {
+			oldLines.insert(lineWidget->line(), lineWidget);
+		}
+		QVector<LineWidget*> newLines;
+		for(int i = firstLine; i <= lastLine; ++i) {
+			newLines.append(oldLines.take(siblings[i]));
+		}
+		for(LineWidget* lineWidget : oldLines) {
+			recycleLineWidget(lineWidget);
+		}
+		for(int i = 0, n = newLines.size(); i < n; ++i) {
+			if(!newLines[i]) {
+				newLines[i] = m_spareLines.isEmpty() ? new LineWidget(this) : m_spareLines.takeLast();
+				newLines[i]->setLine(siblings[firstLine + i]);
+			}
+			if(m_linesLayout->indexOf(newLines[i]) != i) {
+				m_linesLayout->removeWidget(newLines[i]);
+				m_linesLayout->insertWidget(i, newLines[i]);
 			}
+			newLines[i]->show();
 		}
-		qDeleteAll(m_currentLines);
 		m_currentLines = newLines;
 		m_currentLine = lineItem;
+		pinPage(lineItem->page());
 		repositionWidget();
 	}
 
 	// Select selected word or first item of middle line
-	LineEdit* focusLineEdit = static_cast<LineEdit*>(m_currentLines[lineItem]->children()[wordItem ? wordItem->index() : 0]);
+	LineEdit* focusLineEdit = m_currentLines[targetLine - firstLine]->lineEdits().value(wordItem ? wordItem->index() : 0);
 	if(focusLineEdit && !m_treeView->hasFocus()) {
 		focusLineEdit->setFocus();
 	}
 
 }
 
+void HOCRProofReadWidget::recycleLineWidget(LineWidget* lineWidget) {
+	m_linesLayout->removeWidget(lineWidget);
+	lineWidget->hide();
+	lineWidget->setLine(nullptr);
+	m_spareLines.append(lineWidget);
+}
+
+void HOCRProofReadWidget::onModelDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles) {
+	if(m_wordEdits.isEmpty() || topLeft.column() > 0 || topLeft.parent() != bottomRight.parent()) {
+		return;
+	}
+	HOCRDocument* document = static_cast<HOCRDocument*>(m_treeView->model());
+	for(int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+		LineEdit* lineEdit = m_wordEdits.value(document->itemAtIndex(topLeft.sibling(row, 0)));
+		if(lineEdit) {
+			lineEdit->modelDataChanged(roles);
+		}
+	}
+}
+
+void HOCRProofReadWidget::onAttributeChanged(const QModelIndex& index, const QString& name, const QString& /*value*/) {
+	HOCRDocument* document = static_cast<HOCRDocument*>(m_treeView->model());
+	LineEdit* lineEdit = m_wordEdits.value(document->itemAtIndex(index));
+	if(lineEdit) {
+		lineEdit->attributeChanged(name);
+	}
+}
+
 void HOCRProofReadWidget::repositionWidget() {
 
 	if(m_currentLines.isEmpty() || !m_enabled) {
@@ -390,12 +495,12 @@ void HOCRProofReadWidget::repositionWidget() {
 	int frameXmin = std::numeric_limits<int>::max();
 	int frameXmax = 0;
 	QPoint sceneCorner = displayer->getSceneBoundingRect().toRect().topLeft();
-	for(QWidget* lineWidget : m_currentLines) {
-		if(lineWidget->children().isEmpty()) {
+	for(LineWidget* lineWidget : m_currentLines) {
+		if(lineWidget->lineEdits().isEmpty()) {
 			continue;
 		}
 		// First word
-		LineEdit* lineEdit = static_cast<LineEdit*>(lineWidget->children()[0]);
+		LineEdit* lineEdit = lineWidget->lineEdits().first();
 		QPoint bottomLeft = displayer->mapFromScene(lineEdit->item()->bbox().translated(sceneCorner).bottomLeft());
 		frameXmin = std::min(frameXmin, bottomLeft.x());
 	}
@@ -409,9 +514,8 @@ void HOCRProofReadWidget::repositionWidget() {
 	double avgFactor = 0.0;
 	int nFactors = 0;
 	// First pass: min scaling factor, move to correct location
-	for(QWidget* lineWidget : m_currentLines) {
-		for(int i = 0, n = lineWidget->children().count(); i < n; ++i) {
-			LineEdit* lineEdit = static_cast<LineEdit*>(lineWidget->children()[i]);
+	for(LineWidget* lineWidget : m_currentLines) {
+		for(LineEdit* lineEdit : lineWidget->lineEdits()) {
 			QRect sceneBBox = lineEdit->item()->bbox().translated(sceneCorner);
 			QPoint bottomLeft = displayer->mapFromScene(sceneBBox.bottomLeft());
 			QPoint bottomRight = displayer->mapFromScene(sceneBBox.bottomRight());
@@ -429,12 +533,13 @@ void HOCRProofReadWidget::repositionWidget() {
 	// Second pass: apply font sizes, set line heights
 	ft.setPointSizeF(ft.pointSizeF() * avgFactor);
 	fm = QFontMetrics(ft);
-	for(QWidget* lineWidget : m_currentLines) {
-		for(int i = 0, n = lineWidget->children().count(); i < n; ++i) {
-			LineEdit* lineEdit = static_cast<LineEdit*>(lineWidget->children()[i]);
+	for(LineWidget* lineWidget : m_currentLines) {
+		for(LineEdit* lineEdit : lineWidget->lineEdits()) {
 			QFont lineEditFont = lineEdit->font();
-			lineEditFont.setPointSizeF(ft.pointSizeF() + m_fontSizeDiff);
-			lineEdit->setFont(lineEditFont);
+			if(lineEditFont.pointSizeF() != ft.pointSizeF() + m_fontSizeDiff) {
+				lineEditFont.setPointSizeF(ft.pointSizeF() + m_fontSizeDiff);
+				lineEdit->setFont(lineEditFont);
+			}
 			lineEdit->setFixedHeight(fm.height() + 5);
 		}
 		lineWidget->setFixedHeight(fm.height() + 10);
@@ -20,14 +20,17 @@
 #ifndef HOCRPROOFREADWIDGET_HH
 #define HOCRPROOFREADWIDGET_HH
 
-#include <QMap>
 #include <QFrame>
+#include <QHash>
+#include <QVector>
 
 class QLabel;
+class QModelIndex;
 class QSpinBox;
 class QTreeView;
 class QVBoxLayout;
 class HOCRItem;
+class HOCRPage;
 
 class HOCRProofReadWidget : public QFrame {
 	Q_OBJECT
@@ -42,13 +45,18 @@ public:
 
 private:
 	class LineEdit;
+	class LineWidget;
 
 	QTreeView* m_treeView = nullptr;
 	QVBoxLayout* m_linesLayout = nullptr;
 	const HOCRItem* m_currentLine = nullptr;
+	int m_pinnedPageId = -1;
 	QWidget* m_controlsWidget = nullptr;
 	QLabel* m_confidenceLabel = nullptr;
-	QMap<const HOCRItem*, QWidget*> m_currentLines;
+	// Widgets of the shown lines in display order, and hidden ones kept for reuse
+	QVector<LineWidget*> m_currentLines;
+	QVector<LineWidget*> m_spareLines;
+	QHash<const HOCRItem*, LineEdit*> m_wordEdits;
 	QSpinBox* m_spinLinesBefore = nullptr;
 	QSpinBox* m_spinLinesAfter = nullptr;
 	int m_fontSizeDiff = 0;
@@ -58,10 +66,14 @@ private:
 	bool focusNextPrevChild(bool) override { return false; }
 
 	void repositionWidget();
+	void recycleLineWidget(LineWidget* lineWidget);
+	void pinPage(const HOCRPage* page);
 
 private slots:
 	void updateWidget(bool force = false);
 	void showShortcutsDialog();
+	void onModelDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+	void onAttributeChanged(const QModelIndex& index, const QString& name, const QString& value);
 };
 
 
@@ -57,8 +57,8 @@ void HOCRTextExporter::printItem(QTextStream& outputStream, const HOCRItem* item
 	if(!item->isEnabled()) {
 		return;
 	}
-	QString itemClass = item->itemClass();
-	if(itemClass == "ocrx_word") {
+	HOCRItem::ItemClass itemClass = item->itemClassId();
+	if(itemClass == HOCRItem::ItemClass::Word) {
 		outputStream << item->text();
 		if(!lastChild) {
 			outputStream << " ";
@@ -68,7 +68,7 @@ void HOCRTextExporter::printItem(QTextStream& outputStream, const HOCRItem* item
 			printItem(outputStream, item->children()[i], i == n - 1);
 		}
 	}
-	if(itemClass == "ocr_line" || itemClass == "ocr_par") {
+	if(itemClass == HOCRItem::ItemClass::Line || itemClass == HOCRItem::ItemClass::Par) {
 		outputStream << "\n";
 	}
 }
@@ -18,18 +18,24 @@
  */
 
 #include <QApplication>
+#include <QDataStream>
 #include <QDir>
 #include <QDomDocument>
 #include <QFileInfo>
 #include <QFontComboBox>
+#include <QFontDatabase>
 #include <QImage>
 #include <QInputDialog>
 #include <QShortcut>
 #include <QStyledItemDelegate>
 #include <QMessageBox>
 #include <QPointer>
+#include <QSaveFile>
 #include <QStandardItemModel>
-#include <QSyntaxHighlighter>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTextLayout>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtSpell.hpp>
 #include <algorithm>
 #include <cmath>
@@ -51,12 +57,15 @@
 #include "OutputEditorHOCR.hh"
 #include "Recognizer.hh"
 #include "SourceManager.hh"
+#include "SubstitutionMatcher.hh"
 #include "Utils.hh"
 
 
-class OutputEditorHOCR::HTMLHighlighter : public QSyntaxHighlighter {
+// Highlights the blocks of the source view as they are scrolled into view, the source of a page item
+// can be hundreds of KB, highlighting all of it when it is set would stall the view
+class OutputEditorHOCR::HTMLHighlighter : public QObject {
 public:
-	HTMLHighlighter(QTextDocument* document) : QSyntaxHighlighter(document) {
+	HTMLHighlighter(QPlainTextEdit* edit) : QObject(edit), m_edit(edit) {
 		mFormatMap[NormalState].setForeground(QColor(Qt::black));
 		mFormatMap[InTag].setForeground(QColor(75, 75, 255));
 		mFormatMap[InAttrKey].setForeground(QColor(75, 200, 75));
@@ -71,6 +80,8 @@ public:
 		mStateMap[InAttrKey].append({QRegularExpression("\\s"), NormalState, false});
 		mStateMap[InAttrValue].append({QRegularExpression("'[^']*'"), InTag, true});
 		mStateMap[InAttrValueDblQuote].append({QRegularExpression("\"[^\"]*\""), InTag, true});
+
+		connect(edit, &QPlainTextEdit::updateRequest, this, &HTMLHighlighter::highlightVisibleBlocks);
 	}
 
 private:
@@ -81,13 +92,36 @@ private:
 		bool addMatched; // add matched length to pos
 	};
 
+	QPlainTextEdit* m_edit;
 	QMap<State, QTextCharFormat> mFormatMap;
 	QMap<State, QList<Rule>> mStateMap;
+	bool m_highlighting = false;
+
+	void highlightVisibleBlocks() {
+		// Applying the formats triggers another update request
+		if(m_highlighting) {
+			return;
+		}
+		m_highlighting = true;
+		QTextBlock block = m_edit->cursorForPosition(QPoint(0, 0)).block();
+		int last = m_edit->cursorForPosition(QPoint(0, m_edit->viewport()->height())).blockNumber();
+		for(; block.isValid() && block.blockNumber() <= last; block = block.next()) {
+			// The user state of highlighted blocks holds their end state, new blocks start out with -1
+			if(block.userState() < 0) {
+				highlightBlock(block);
+			}
+		}
+		m_highlighting = false;
+	}
 
-	void highlightBlock(const QString& text) override {
+	void highlightBlock(QTextBlock block) {
+		const QString text = block.text();
 		int pos = 0;
 		int len = text.length();
-		State state = static_cast<State>(previousBlockState());
+		// Tags do not span lines in the generated source, so an unhighlighted previous block is assumed to end outside of a tag
+		QTextBlock prev = block.previous();
+		State state = prev.isValid() && prev.userState() >= 0 ? static_cast<State>(prev.userState() - 1) : NormalState;
+		QVector<QTextLayout::FormatRange> formats;
 		while(pos < len) {
 			State minState = state;
 			int minPos = -1;
@@ -99,20 +133,41 @@ private:
 				}
 			}
 			if(minPos == -1) {
-				setFormat(pos, len - pos, mFormatMap[state]);
+				formats.append({pos, len - pos, mFormatMap[state]});
 				pos = len;
 			} else {
-				setFormat(pos, minPos - pos, mFormatMap[state]);
+				formats.append({pos, minPos - pos, mFormatMap[state]});
 				pos = minPos;
 				state = minState;
 			}
 		}
-		setCurrentBlockState(state);
+		block.setUserState(state + 1);
+		block.layout()->setFormats(formats);
+		m_edit->document()->markContentsDirty(block.position(), block.length());
 	}
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
+class OutputEditorHOCR::OpenProgressMonitor : public MainWindow::ProgressMonitor {
+public:
+	OpenProgressMonitor(qint64 totalBytes) : MainWindow::ProgressMonitor(1), m_totalBytes(std::max(qint64(1), totalBytes)) {}
+	void setBytesRead(qint64 bytesRead) {
+		QMutexLocker locker(&mMutex);
+		m_bytesRead = bytesRead;
+	}
+	int getProgress() const override {
+		QMutexLocker locker(&mMutex);
+		return (m_bytesRead * 100) / m_totalBytes;
+	}
+
+private:
+	qint64 m_totalBytes;
+	qint64 m_bytesRead = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 HOCRAttributeEditor::HOCRAttributeEditor(const QString& value, HOCRDocument* doc, const QModelIndex& itemIndex, const QString& attrName, const QString& attrItemClass)
 	: QLineEdit(value), m_doc(doc), m_itemIndex(itemIndex), m_attrName(attrName), m_origValue(value), m_attrItemClass(attrItemClass) {
 	setFrame(false);
@@ -274,7 +329,8 @@ void OutputEditorHOCR::HOCRBatchProcessor::appendOutput(QIODevice* dev, tesserac
 
 Q_DECLARE_METATYPE(OutputEditorHOCR::HOCRReadSessionData)
 
-OutputEditorHOCR::OutputEditorHOCR(DisplayerToolHOCR* tool) {
+OutputEditorHOCR::OutputEditorHOCR(DisplayerToolHOCR* tool)
+	: m_journal("hocr") {
 	static int reg = qRegisterMetaType<QList<QRect>>("QList<QRect>");
 	Q_UNUSED(reg);
 
@@ -284,13 +340,14 @@ OutputEditorHOCR::OutputEditorHOCR(DisplayerToolHOCR* tool) {
 	m_tool = tool;
 	m_widget = new QWidget;
 	ui.setupUi(m_widget);
-	m_highlighter = new HTMLHighlighter(ui.plainTextEditOutput->document());
+	m_highlighter = new HTMLHighlighter(ui.plainTextEditOutput);
 
 	m_preview = new QGraphicsPixmapItem();
 	m_preview->setTransformationMode(Qt::SmoothTransformation);
 	m_preview->setZValue(2);
 	MAIN->getDisplayer()->scene()->addItem(m_preview);
 	m_previewTimer.setSingleShot(true);
+	m_previewCache.setMaxCost(256 * 1024);
 
 	ui.actionOutputReplace->setShortcut(Qt::CTRL | Qt::Key_F);
 	ui.actionOutputSaveHOCR->setShortcut(Qt::CTRL | Qt::Key_S);
@@ -299,6 +356,13 @@ OutputEditorHOCR::OutputEditorHOCR(DisplayerToolHOCR* tool) {
 
 	m_document = new HOCRDocument(ui.treeViewHOCR);
 	ui.treeViewHOCR->setModel(m_document);
+	// Memory cap in MiB for the item trees of unmodified pages, beyond which they are evicted
+	ADD_SETTING(VarSetting<int>("hocrmemorycap", 1024));
+	VarSetting<int>* memoryCapSetting = ConfigSettings::get<VarSetting<int>>("hocrmemorycap");
+	m_document->setMemoryCap(qint64(memoryCapSetting->getValue()) << 20);
+	connect(memoryCapSetting, &AbstractSetting::changed, this, [this, memoryCapSetting] {
+		m_document->setMemoryCap(qint64(memoryCapSetting->getValue()) << 20);
+	});
 	ui.treeViewHOCR->setContextMenuPolicy(Qt::CustomContextMenu);
 	ui.treeViewHOCR->header()->setStretchLastSection(false);
 	ui.treeViewHOCR->header()->setSectionResizeMode(0, QHeaderView::Stretch);
@@ -338,6 +402,7 @@ OutputEditorHOCR::OutputEditorHOCR(DisplayerToolHOCR* tool) {
 	connect(ui.actionPreview, &QAction::toggled, this, &OutputEditorHOCR::previewToggled);
 	connect(ui.actionProofread, &QAction::toggled, m_proofReadWidget, &HOCRProofReadWidget::setProofreadEnabled);
 	connect(&m_previewTimer, &QTimer::timeout, this, &OutputEditorHOCR::updatePreview);
+	connect(&m_previewWatcher, &QFutureWatcher<QImage>::finished, this, [this] { previewRendered(m_previewJobGeneration, m_previewWatcher.future().result()); });
 	connect(ui.searchFrame, &SearchReplaceFrame::findReplace, this, &OutputEditorHOCR::findReplace);
 	connect(ui.searchFrame, &SearchReplaceFrame::replaceAll, this, &OutputEditorHOCR::replaceAll);
 	connect(ui.searchFrame, &SearchReplaceFrame::applySubstitutions, this, &OutputEditorHOCR::applySubstitutions);
@@ -355,18 +420,26 @@ OutputEditorHOCR::OutputEditorHOCR(DisplayerToolHOCR* tool) {
 	connect(m_document, &HOCRDocument::itemAttributeChanged, this, &OutputEditorHOCR::setModified);
 	connect(m_document, &HOCRDocument::itemAttributeChanged, this, &OutputEditorHOCR::updateSourceText);
 	connect(m_document, &HOCRDocument::itemAttributeChanged, this, &OutputEditorHOCR::itemAttributeChanged);
+	connect(m_document, &HOCRDocument::dataChanged, this, &OutputEditorHOCR::previewDataChanged);
+	connect(m_document, &HOCRDocument::rowsInserted, this, &OutputEditorHOCR::previewRowsInserted);
+	connect(m_document, &HOCRDocument::rowsAboutToBeRemoved, this, &OutputEditorHOCR::previewRowsAboutToBeRemoved);
+	connect(m_document, &HOCRDocument::modelReset, this, &OutputEditorHOCR::resetPreview);
 	connect(ui.comboBoxNavigate, qOverload<int>(&QComboBox::currentIndexChanged), this, &OutputEditorHOCR::navigateTargetChanged);
 	connect(ui.actionNavigateNext, &QAction::triggered, this, &OutputEditorHOCR::navigateNext);
 	connect(ui.actionNavigatePrev, &QAction::triggered, this, &OutputEditorHOCR::navigatePrev);
 	connect(ui.actionExpandAll, &QAction::triggered, this, &OutputEditorHOCR::expandItemClass);
 	connect(ui.actionCollapseAll, &QAction::triggered, this, &OutputEditorHOCR::collapseItemClass);
 	connect(MAIN->getDisplayer(), &Displayer::imageChanged, this, &OutputEditorHOCR::sourceChanged);
+	connect(&m_journal, &EditJournal::aboutToFlush, this, &OutputEditorHOCR::updateJournal);
+	connect(&m_journal, &EditJournal::compactionRequested, this, &OutputEditorHOCR::compactJournal);
+	connect(m_document, &HOCRDocument::itemEdited, this, &OutputEditorHOCR::journalItemEdit);
 
 	setFont();
 }
 
 OutputEditorHOCR::~OutputEditorHOCR() {
 	m_previewTimer.stop();
+	m_previewWatcher.waitForFinished();
 	delete m_preview;
 	delete m_proofReadWidget;
 	delete m_widget;
@@ -392,6 +465,8 @@ void OutputEditorHOCR::setModified() {
 	m_preview->setVisible(false);
 	m_previewTimer.start(100); // Use a timer because setModified is potentially called a large number of times when the HOCR tree changes
 	m_modified = true;
+	m_sourceIndex = QPersistentModelIndex();
+	m_journal.scheduleFlush();
 }
 
 OutputEditorHOCR::ReadSessionData* OutputEditorHOCR::initRead(tesseract::TessBaseAPI& tess) {
@@ -435,7 +510,7 @@ void OutputEditorHOCR::addPage(const QString& hocrText, HOCRReadSessionData data
 	attrs["res"] = QString::number(data.pageInfo.resolution);
 	pageDiv.setAttribute("title", HOCRItem::serializeAttrGroup(attrs));
 
-	QModelIndex index = m_document->insertPage(data.insertIndex, pageDiv, true);
+	QModelIndex index = m_document->insertPage(data.insertIndex, pageDiv, true, MAIN->getConfig()->langSpecs());
 
 	expandCollapseChildren(index, true);
 	MAIN->setOutputPaneVisible(true);
@@ -443,13 +518,7 @@ void OutputEditorHOCR::addPage(const QString& hocrText, HOCRReadSessionData data
 }
 
 bool OutputEditorHOCR::containsSource(const QString& source, int sourcePage) const {
-	for(int i = 0, n = m_document->pageCount(); i < n; ++i) {
-		const HOCRPage* page = m_document->page(i);
-		if(page->pageNr() == sourcePage && page->sourceFile() == source) {
-			return true;
-		}
-	}
-	return false;
+	return m_document->searchPage(source, sourcePage).isValid();
 }
 
 void OutputEditorHOCR::navigateTargetChanged() {
@@ -461,11 +530,12 @@ void OutputEditorHOCR::navigateTargetChanged() {
 
 void OutputEditorHOCR::expandCollapseItemClass(bool expand) {
 	QString target = ui.comboBoxNavigate->itemData(ui.comboBoxNavigate->currentIndex()).toString();
+	HOCRItem::ItemClass targetClass = HOCRItem::itemClassFromName(target);
 	QModelIndex start = m_document->index(0, 0);
 	QModelIndex next = start;
 	do {
 		const HOCRItem* item = m_document->itemAtIndex(next);
-		if(item && item->itemClass() == target) {
+		if(item && item->itemClassId() == targetClass && (targetClass != HOCRItem::ItemClass::Other || item->itemClass() == target)) {
 			if(expand) {
 				ui.treeViewHOCR->setExpanded(next, expand);
 				for(QModelIndex parent = next.parent(); parent.isValid(); parent = parent.parent()) {
@@ -537,7 +607,7 @@ void OutputEditorHOCR::showItemProperties(const QModelIndex& index, const QModel
 	m_tool->setAction(DisplayerToolHOCR::ACTION_NONE);
 	const HOCRItem* prevItem = m_document->itemAtIndex(prev);
 	ui.tableWidgetProperties->setRowCount(0);
-	ui.plainTextEditOutput->setPlainText("");
+	updateSourceText();
 
 	const HOCRItem* currentItem = m_document->itemAtIndex(index);
 	if(!currentItem) {
@@ -587,8 +657,6 @@ void OutputEditorHOCR::showItemProperties(const QModelIndex& index, const QModel
 		}
 	}
 
-	ui.plainTextEditOutput->setPlainText(currentItem->toHtml());
-
 	if(showPage(page)) {
 		// Update preview if necessary
 		if(!prevItem || prevItem->page() != page) {
@@ -596,7 +664,7 @@ void OutputEditorHOCR::showItemProperties(const QModelIndex& index, const QModel
 		}
 		// Minimum bounding box
 		QRect minBBox;
-		if(currentItem->itemClass() == "ocr_page") {
+		if(currentItem->itemClassId() == HOCRItem::ItemClass::Page) {
 			minBBox = currentItem->bbox();
 		} else {
 			for(const HOCRItem* child : currentItem->children()) {
@@ -654,21 +722,28 @@ void OutputEditorHOCR::updateCurrentItemBBox(QRect bbox) {
 }
 
 void OutputEditorHOCR::updateSourceText() {
-	if(ui.tabWidgetProps->currentWidget() == ui.plainTextEditOutput) {
-		QModelIndex current = ui.treeViewHOCR->selectionModel()->currentIndex();
-		const HOCRItem* currentItem = m_document->itemAtIndex(current);
-		if(currentItem) {
-			ui.plainTextEditOutput->setPlainText(currentItem->toHtml());
-		}
+	// The source is only serialized while the source tab is shown, and kept until the document is modified
+	if(ui.tabWidgetProps->currentWidget() != ui.plainTextEditOutput) {
+		return;
 	}
+	QModelIndex current = ui.treeViewHOCR->selectionModel()->currentIndex();
+	current = current.sibling(current.row(), 0);
+	if(m_sourceIndex.isValid() && m_sourceIndex == current) {
+		return;
+	}
+	const HOCRItem* currentItem = m_document->itemAtIndex(current);
+	m_sourceIndex = currentItem ? QPersistentModelIndex(current) : QPersistentModelIndex();
+	ui.plainTextEditOutput->setPlainText(currentItem ? currentItem->toHtml() : QString());
 }
 
 void OutputEditorHOCR::itemAttributeChanged(const QModelIndex& itemIndex, const QString& name, const QString& /*value*/) {
 	const HOCRItem* currentItem = m_document->itemAtIndex(itemIndex);
+	// The previous bounding box is not known anymore
+	invalidatePreview(currentItem, name == "title:bbox");
 	if(name == "title:bbox" && currentItem) {
 		// Minimum bounding box
 		QRect minBBox;
-		if(currentItem->itemClass() == "ocr_page") {
+		if(currentItem->itemClassId() == HOCRItem::ItemClass::Page) {
 			minBBox = currentItem->bbox();
 		} else {
 			for(const HOCRItem* child : currentItem->children()) {
@@ -770,8 +845,8 @@ void OutputEditorHOCR::showTreeWidgetContextMenu(const QPoint& point) {
 		QMenu menu;
 		std::sort(rows.begin(), rows.end());
 		bool consecutive = (rows.last() - rows.first()) == nIndices - 1;
-		bool graphics = firstItem->itemClass() == "ocr_graphic";
-		bool pages = firstItem->itemClass() == "ocr_page";
+		bool graphics = firstItem->itemClassId() == HOCRItem::ItemClass::Graphic;
+		bool pages = firstItem->itemClassId() == HOCRItem::ItemClass::Page;
 		bool sameClass = classes.size() == 1;
 
 		QAction* actionMerge = nullptr;
@@ -779,7 +854,7 @@ void OutputEditorHOCR::showTreeWidgetContextMenu(const QPoint& point) {
 		QAction* actionSwap = nullptr;
 		if(consecutive && !graphics && !pages && sameClass) { // Merging allowed
 			actionMerge = menu.addAction(_("Merge"));
-			if(firstItem->itemClass() != "ocr_carea") {
+			if(firstItem->itemClassId() != HOCRItem::ItemClass::CArea) {
 				actionSplit = menu.addAction(_("Split from parent"));
 			}
 		}
@@ -827,23 +902,23 @@ void OutputEditorHOCR::showTreeWidgetContextMenu(const QPoint& point) {
 	QAction* actionRemove = nullptr;
 	QAction* actionExpand = nullptr;
 	QAction* actionCollapse = nullptr;
-	QString itemClass = item->itemClass();
-	if(itemClass == "ocr_page") {
+	HOCRItem::ItemClass itemClass = item->itemClassId();
+	if(itemClass == HOCRItem::ItemClass::Page) {
 		actionAddGraphic = menu.addAction(_("Add graphic region"));
 		actionAddCArea = menu.addAction(_("Add text block"));
-	} else if(itemClass == "ocr_carea") {
+	} else if(itemClass == HOCRItem::ItemClass::CArea) {
 		actionAddPar = menu.addAction(_("Add paragraph"));
-	} else if(itemClass == "ocr_par") {
+	} else if(itemClass == HOCRItem::ItemClass::Par) {
 		actionAddLine = menu.addAction(_("Add line"));
-	} else if(itemClass == "ocr_line") {
+	} else if(itemClass == HOCRItem::ItemClass::Line) {
 		actionAddWord = menu.addAction(_("Add word"));
-	} else if(itemClass == "ocrx_word") {
+	} else if(itemClass == HOCRItem::ItemClass::Word) {
 		m_document->addSpellingActions(&menu, index);
 	}
 	if(!menu.actions().isEmpty()) {
 		menu.addSeparator();
 	}
-	if(itemClass == "ocr_par" || itemClass == "ocr_line" || itemClass == "ocrx_word") {
+	if(itemClass == HOCRItem::ItemClass::Par || itemClass == HOCRItem::ItemClass::Line || itemClass == HOCRItem::ItemClass::Word) {
 		actionSplit = menu.addAction(_("Split from parent"));
 	}
 	actionRemove = menu.addAction(_("Remove"));
@@ -897,7 +972,7 @@ void OutputEditorHOCR::pickItem(const QPoint& point) {
 	QModelIndex index = m_document->searchAtCanvasPos(pageIndex, newPoint);
 	ui.treeViewHOCR->setCurrentIndex(index);
 	const HOCRItem* item = m_document->itemAtIndex(index);
-	if(item->itemClass() != "ocrx_word" && item->itemClass() != "ocr_line") {
+	if(item->itemClassId() != HOCRItem::ItemClass::Word && item->itemClassId() != HOCRItem::ItemClass::Line) {
 		ui.treeViewHOCR->setFocus();
 	}
 }
@@ -911,7 +986,7 @@ bool OutputEditorHOCR::open(InsertMode mode, QStringList files) {
 		return false;
 	}
 	if(files.isEmpty()) {
-		files = FileDialogs::openDialog(_("Open hOCR File"), "", "outputdir", QString("%1 (*.html)").arg(_("hOCR HTML Files")), true);
+		files = FileDialogs::openDialog(_("Open hOCR File"), "", "outputdir", QString("%1 (*.html);;%2 (*.gihocr)").arg(_("hOCR HTML Files")).arg(_("hOCR Project Files")), true);
 	}
 	if(files.isEmpty()) {
 		return false;
@@ -919,28 +994,83 @@ bool OutputEditorHOCR::open(InsertMode mode, QStringList files) {
 	int pos = mode == InsertMode::InsertBefore ? currentPage() : m_document->pageCount();
 	QStringList failed;
 	QStringList invalid;
-	int added = 0;
+	QStringList invalidProjects;
+	qint64 totalSize = 0;
 	for(const QString& filename : files) {
-		QFile file(filename);
-		if(!file.open(QIODevice::ReadOnly)) {
-			failed.append(filename);
-			continue;
+		totalSize += QFileInfo(filename).size();
+	}
+	OpenProgressMonitor monitor(totalSize);
+	MAIN->showProgress(&monitor);
+	QVector<HOCRPage*> pages;
+	QVector<JournalSourceFile> sources;
+	QList<Config::Lang> langSpecs = MAIN->getConfig()->langSpecs();
+	Utils::busyTask([&] {
+		qint64 offset = 0;
+		for(const QString& filename : files) {
+			int first = pages.size();
+			// Project files are mapped by the document, their pages are loaded when accessed
+			if(HOCRDocument::isProjectFile(filename)) {
+				if(!m_document->readProject(filename, pages, QFileInfo(filename).absolutePath())) {
+					invalidProjects.append(filename);
+				}
+				sources.append({filename, QVector<int>(pages.size() - first)});
+				offset += QFileInfo(filename).size();
+				monitor.setBytesRead(offset);
+				continue;
+			}
+			QFile file(filename);
+			if(!file.open(QIODevice::ReadOnly)) {
+				failed.append(filename);
+				continue;
+			}
+			// Stream the file from a memory mapping (if possible) so that only the model is held in memory
+			QByteArray data;
+			uchar* map = file.map(0, file.size());
+			if(map) {
+				data = QByteArray::fromRawData(reinterpret_cast<const char*>(map), file.size());
+			} else {
+				data = file.readAll();
+			}
+			bool valid = m_document->readPages(data, pages, QFileInfo(filename).absolutePath(), langSpecs, [&](qint64 bytesRead) {
+				monitor.setBytesRead(offset + bytesRead);
+				return !monitor.cancelled();
+			});
+			if(monitor.cancelled()) {
+				return false;
+			}
+			if(!valid) {
+				invalid.append(filename);
+			}
+			sources.append({filename, QVector<int>(pages.size() - first)});
+			offset += file.size();
 		}
-		QDomDocument doc;
-		doc.setContent(&file);
-		QDomElement div = doc.firstChildElement("html").firstChildElement("body").firstChildElement("div");
-		if(div.isNull() || div.attribute("class") != "ocr_page") {
-			invalid.append(filename);
+		return true;
+	}, _("Opening hOCR files..."));
+	MAIN->hideProgress();
+	if(monitor.cancelled()) {
+		qDeleteAll(pages);
+		pages.clear();
+		failed.clear();
+		invalid.clear();
+		invalidProjects.clear();
+		sources.clear();
+	}
+	// Unmodified pages are journaled by the file they can be read from again
+	int index = 0;
+	for(JournalSourceFile& source : sources) {
+		if(source.pageIds.isEmpty()) {
 			continue;
 		}
-		while(!div.isNull()) {
-			// Need to query next before adding page since the element is reparented
-			QDomElement nextDiv = div.nextSiblingElement("div");
-			m_document->insertPage(pos++, div, false, QFileInfo(filename).absolutePath());
-			div = nextDiv;
-			++added;
+		for(int& pageId : source.pageIds) {
+			const HOCRPage* page = pages[index++];
+			pageId = page->pageId();
+			m_journalRevisions.insert(pageId, page->revision());
 		}
+		journalAppend(JournalSource, [&](QDataStream & ds) { ds << source.filename << source.pageIds; });
+		m_journalSources.append(source);
 	}
+	m_document->insertPages(pos, pages);
+	int added = pages.size();
 	if(added > 0) {
 		m_modified = mode != InsertMode::Replace;
 		if(mode == InsertMode::Replace && m_filebasename.isEmpty()) {
@@ -956,6 +1086,9 @@ bool OutputEditorHOCR::open(InsertMode mode, QStringList files) {
 	if(!invalid.isEmpty()) {
 		errorMsg.append(_("The following files are not valid hOCR HTML:\n%1").arg(invalid.join("\n")));
 	}
+	if(!invalidProjects.isEmpty()) {
+		errorMsg.append(_("The following files are not valid hOCR project files:\n%1").arg(invalidProjects.join("\n")));
+	}
 	if(!errorMsg.isEmpty()) {
 		QMessageBox::critical(MAIN, _("Unable to open files"), errorMsg.join("\n\n"));
 	}
@@ -987,42 +1120,69 @@ bool OutputEditorHOCR::save(const QString& filename) {
 				suggestion = _("output");
 			}
 		}
-		outname = FileDialogs::saveDialog(_("Save hOCR Output..."), suggestion + ".html", "outputdir", QString("%1 (*.html)").arg(_("hOCR HTML Files")));
+		outname = FileDialogs::saveDialog(_("Save hOCR Output..."), suggestion + ".html", "outputdir", QString("%1 (*.html);;%2 (*.gihocr)").arg(_("hOCR HTML Files")).arg(_("hOCR Project Files")));
 		if(outname.isEmpty()) {
 			return false;
 		}
 	}
-	QFile file(outname);
+	// Write to a temporary file which replaces the destination only once the document was written completely
+	QSaveFile file(outname);
 	if(!file.open(QIODevice::WriteOnly)) {
 		QMessageBox::critical(MAIN, _("Failed to save output"), _("Check that you have writing permissions in the selected folder."));
 		return false;
 	}
-	QByteArray current = setlocale(LC_ALL, NULL);
-	setlocale(LC_ALL, "C");
-	tesseract::TessBaseAPI tess;
-	setlocale(LC_ALL, current.constData());
-	QString header = QString(
-	                     "<!DOCTYPE html>\n"
-	                     "<html>\n"
-	                     "<head>\n"
-	                     " <title>%1</title>\n"
-	                     " <meta charset=\"utf-8\" /> \n"
-	                     " <meta name='ocr-system' content='tesseract %2' />\n"
-	                     " <meta name='ocr-capabilities' content='ocr_page ocr_carea ocr_par ocr_line ocrx_word'/>\n"
-	                     "</head>\n").arg(QFileInfo(outname).fileName()).arg(tess.Version());
-	file.write(header.toUtf8());
+	bool project = QFileInfo(outname).suffix().toLower() == "gihocr";
+	if(!project) {
+		QByteArray current = setlocale(LC_ALL, NULL);
+		setlocale(LC_ALL, "C");
+		tesseract::TessBaseAPI tess;
+		setlocale(LC_ALL, current.constData());
+		QString header = QString(
+		                     "<!DOCTYPE html>\n"
+		                     "<html>\n"
+		                     "<head>\n"
+		                     " <title>%1</title>\n"
+		                     " <meta charset=\"utf-8\" /> \n"
+		                     " <meta name='ocr-system' content='tesseract %2' />\n"
+		                     " <meta name='ocr-capabilities' content='ocr_page ocr_carea ocr_par ocr_line ocrx_word'/>\n"
+		                     "</head>\n").arg(QFileInfo(outname).fileName()).arg(tess.Version());
+		file.write(header.toUtf8());
+	}
 	m_document->convertSourcePaths(QFileInfo(outname).absolutePath(), false);
-	file.write(m_document->toHTML().toUtf8());
+	bool success = project ? m_document->writeProject(&file) : m_document->writeHTML(&file);
 	m_document->convertSourcePaths(QFileInfo(outname).absolutePath(), true);
-	file.write("</html>\n");
+	if(!project) {
+		file.write("</html>\n");
+	}
+	// A project file which is replaced must not remain mapped, which would prevent replacing it on some platforms
+	if(success) {
+		m_document->releaseProjectFile(outname);
+	}
+	if(!success || !file.commit()) {
+		QMessageBox::critical(MAIN, _("Failed to save output"), _("An error occurred while writing the file: %1").arg(file.errorString()));
+		return false;
+	}
 	m_modified = false;
+	m_document->clearModified();
 	QFileInfo finfo(outname);
 	m_filebasename = finfo.absoluteDir().absoluteFilePath(finfo.completeBaseName());
+	// The saved file now contains all pages, nothing remains to be journaled until the next edit
+	JournalSourceFile source{outname, {}};
+	m_journalRevisions.clear();
+	for(int i = 0, n = m_document->pageCount(); i < n; ++i) {
+		const HOCRPage* page = m_document->page(i);
+		source.pageIds.append(page->pageId());
+		m_journalRevisions.insert(page->pageId(), page->revision());
+	}
+	m_journalSources = {source};
+	m_journalEditCounts.clear();
+	m_journalLayout.clear();
+	m_journal.discard();
 	return true;
 }
 
 bool OutputEditorHOCR::crashSave(const QString& filename) const {
-	QFile file(filename);
+	QSaveFile file(filename);
 	if(file.open(QIODevice::WriteOnly)) {
 		QString header = QString(
 		                     "<!DOCTYPE html>\n"
@@ -1034,14 +1194,261 @@ bool OutputEditorHOCR::crashSave(const QString& filename) const {
 		                     "</head>\n").arg(QFileInfo(filename).fileName());
 		file.write(header.toUtf8());
 		m_document->convertSourcePaths(QFileInfo(filename).absolutePath(), false);
-		file.write(m_document->toHTML().toUtf8());
+		bool success = m_document->writeHTML(&file);
 		m_document->convertSourcePaths(QFileInfo(filename).absolutePath(), true);
 		file.write("</html>\n");
-		return true;
+		return success && file.commit();
 	}
 	return false;
 }
 
+void OutputEditorHOCR::journalAppend(JournalRecord type, const std::function<void(QDataStream&)>& write) {
+	if(!m_journal.isActive()) {
+		return;
+	}
+	QByteArray data;
+	QDataStream ds(&data, QIODevice::WriteOnly);
+	ds.setVersion(QDataStream::Qt_5_6);
+	write(ds);
+	m_journal.append(type, data);
+}
+
+void OutputEditorHOCR::updateJournal() {
+	// Only unsaved edits are journaled
+	if(!m_modified) {
+		m_journal.discard();
+		return;
+	}
+	if(!m_journal.isActive()) {
+		if(!m_journal.reset(QByteArray())) {
+			return;
+		}
+		for(const JournalSourceFile& source : m_journalSources) {
+			journalAppend(JournalSource, [&](QDataStream & ds) { ds << source.filename << source.pageIds; });
+		}
+		m_journalLayout.clear();
+	}
+	QVector<int> layout;
+	QHash<int, quint32> revisions;
+	for(int i = 0, n = m_document->pageCount(); i < n; ++i) {
+		const HOCRPage* page = m_document->page(i);
+		int pageId = page->pageId();
+		// Pages with modifications which were not journaled as edits, i.e. structural changes, are journaled as a whole
+		auto it = m_journalRevisions.find(pageId);
+		if(it == m_journalRevisions.end() || it.value() != page->revision()) {
+			QByteArray data = m_document->serializePage(page);
+			journalAppend(JournalPage, [&](QDataStream & ds) { ds << qint32(pageId) << data; });
+			m_journalEditCounts.remove(pageId);
+		}
+		layout.append(pageId);
+		revisions.insert(pageId, page->revision());
+	}
+	m_journalRevisions = revisions;
+	if(layout != m_journalLayout) {
+		journalAppend(JournalLayout, [&](QDataStream & ds) { ds << layout; });
+		m_journalLayout = layout;
+	}
+}
+
+void OutputEditorHOCR::journalItemEdit(const HOCRPage* page, quint32 revision, const HOCRDocument::ItemEdit& edit) {
+	// Only edits of pages whose journaled state is current are journaled by themselves, other pages are journaled as a
+	// whole by the next flush. So are pages with many edits, which would otherwise take long to replay.
+	static constexpr int sMaxEdits = 1000;
+	int pageId = page->pageId();
+	auto it = m_journalRevisions.find(pageId);
+	if(!m_journal.isActive() || it == m_journalRevisions.end() || it.value() != revision) {
+		return;
+	}
+	if(++m_journalEditCounts[pageId] > sMaxEdits) {
+		m_journalRevisions.erase(it);
+		return;
+	}
+	journalAppend(JournalEdit, [&](QDataStream & ds) { ds << qint32(pageId) << quint8(edit.type) << edit.path << edit.name << edit.value << edit.attrItemClass; });
+	it.value() = page->revision();
+}
+
+void OutputEditorHOCR::compactJournal() {
+	// The new snapshot is folded from the journal files in the background
+	updateJournal();
+	m_journal.compact(&OutputEditorHOCR::compactJournalRecords);
+}
+
+QByteArray OutputEditorHOCR::compactJournalRecords(const QByteArray& snapshot, const QVector<EditJournal::Record>& journal) {
+	// Of each page, only the most recent source or page record and the edits following it are kept
+	QVector<EditJournal::Record> records;
+	EditJournal::readRecords(snapshot, 0, records);
+	records += journal;
+	QVector<QVector<int>> recordPageIds(records.size());
+	QHash<int, int> base;
+	int layout = -1;
+	for(int i = 0, n = records.size(); i < n; ++i) {
+		QDataStream ds(records[i].data);
+		ds.setVersion(QDataStream::Qt_5_6);
+		if(records[i].type == JournalSource) {
+			QString filename;
+			ds >> filename >> recordPageIds[i];
+			for(int pageId : recordPageIds[i]) {
+				base[pageId] = i;
+			}
+		} else if(records[i].type == JournalPage || records[i].type == JournalEdit) {
+			qint32 pageId;
+			ds >> pageId;
+			recordPageIds[i] = {pageId};
+			if(records[i].type == JournalPage) {
+				base[pageId] = i;
+			}
+		} else if(records[i].type == JournalLayout) {
+			layout = i;
+		}
+	}
+	// Without a layout all pages are kept
+	QSet<int> pageIds;
+	if(layout >= 0) {
+		QDataStream ds(records[layout].data);
+		ds.setVersion(QDataStream::Qt_5_6);
+		QVector<int> layoutIds;
+		ds >> layoutIds;
+		pageIds = QSet<int>(layoutIds.begin(), layoutIds.end());
+	} else {
+		pageIds = QSet<int>(base.keyBegin(), base.keyEnd());
+	}
+	QByteArray result;
+	for(int i = 0, n = records.size(); i < n; ++i) {
+		bool keep = i == layout;
+		for(int pageId : recordPageIds[i]) {
+			if(pageIds.contains(pageId)) {
+				int pageBase = base.value(pageId, -1);
+				keep |= records[i].type == JournalEdit ? pageBase >= 0 && pageBase < i : pageBase == i;
+			}
+		}
+		if(keep) {
+			EditJournal::appendRecord(result, records[i].type, records[i].data);
+		}
+	}
+	return result;
+}
+
+bool OutputEditorHOCR::readJournalSource(const QString& filename, const QList<Config::Lang>& langSpecs, QVector<HOCRPage*>& pages) {
+	if(HOCRDocument::isProjectFile(filename)) {
+		return m_document->readProject(filename, pages, QFileInfo(filename).absolutePath());
+	}
+	QFile file(filename);
+	if(!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	return m_document->readPages(file.readAll(), pages, QFileInfo(filename).absolutePath(), langSpecs);
+}
+
+bool OutputEditorHOCR::recoverJournal(const QString& session, QString& error) {
+	QByteArray snapshot;
+	QVector<EditJournal::Record> journal;
+	if(!EditJournal::read(session, "hocr", snapshot, journal)) {
+		return false;
+	}
+	// The snapshot consists of records as well
+	QVector<EditJournal::Record> records;
+	if(!EditJournal::readRecords(snapshot, 0, records)) {
+		return false;
+	}
+	records += journal;
+	// Pages by journaled id
+	QMap<int, HOCRPage*> pages;
+	QVector<int> layout;
+	bool haveLayout = false;
+	// Without a layout, all journaled ids are expected to be recovered
+	QSet<int> journaledIds;
+	QStringList missingSources;
+	QSet<int> incompletePages;
+	QList<Config::Lang> langSpecs = MAIN->getConfig()->langSpecs();
+	auto setPage = [&](int pageId, HOCRPage* page) {
+		HOCRPage*& entry = pages[pageId];
+		delete entry;
+		entry = page;
+	};
+	Utils::busyTask([&] {
+		for(const EditJournal::Record& record : records) {
+			QDataStream ds(record.data);
+			ds.setVersion(QDataStream::Qt_5_6);
+			if(record.type == JournalSource) {
+				QString filename;
+				QVector<int> pageIds;
+				ds >> filename >> pageIds;
+				journaledIds.unite(QSet<int>(pageIds.begin(), pageIds.end()));
+				QVector<HOCRPage*> filePages;
+				if(!readJournalSource(filename, langSpecs, filePages) && !missingSources.contains(filename)) {
+					missingSources.append(filename);
+				}
+				for(int i = 0, n = filePages.size(); i < n; ++i) {
+					if(i < pageIds.size()) {
+						setPage(pageIds[i], filePages[i]);
+					} else {
+						delete filePages[i];
+					}
+				}
+			} else if(record.type == JournalPage) {
+				qint32 pageId;
+				QByteArray data;
+				ds >> pageId >> data;
+				journaledIds.insert(pageId);
+				HOCRPage* page = m_document->deserializePage(data);
+				if(page) {
+					setPage(pageId, page);
+				}
+			} else if(record.type == JournalEdit) {
+				qint32 pageId;
+				quint8 type;
+				HOCRDocument::ItemEdit edit;
+				ds >> pageId >> type >> edit.path >> edit.name >> edit.value >> edit.attrItemClass;
+				edit.type = static_cast<HOCRDocument::ItemEdit::Type>(type);
+				HOCRPage* page = pages.value(pageId);
+				if(!page || !m_document->applyItemEdit(page, edit)) {
+					incompletePages.insert(pageId);
+				}
+			} else if(record.type == JournalLayout) {
+				ds >> layout;
+				haveLayout = true;
+			}
+		}
+		return true;
+	}, _("Recovering hOCR output..."));
+
+	QVector<HOCRPage*> recovered;
+	if(!haveLayout) {
+		layout = QVector<int>(journaledIds.begin(), journaledIds.end());
+		std::sort(layout.begin(), layout.end());
+	}
+	int missingPages = 0;
+	for(int pageId : layout) {
+		HOCRPage* page = pages.take(pageId);
+		if(page) {
+			recovered.append(page);
+		}
+		// Pages lacking some of their edits are still recovered, but count as missing
+		if(!page || incompletePages.contains(pageId)) {
+			++missingPages;
+		}
+	}
+	qDeleteAll(pages);
+	if(missingPages > 0) {
+		error = _("%1 of %2 pages could not be recovered completely.").arg(missingPages).arg(layout.size());
+		if(!missingSources.isEmpty()) {
+			error += "\n" + _("The following files could not be read:") + "\n" + missingSources.join("\n");
+		}
+	}
+	if(recovered.isEmpty()) {
+		return missingPages == 0;
+	}
+	m_document->insertPages(m_document->pageCount(), recovered);
+	m_modified = true;
+	// Journal the recovered document from scratch
+	m_journalSources.clear();
+	m_journalRevisions.clear();
+	m_journalEditCounts.clear();
+	m_journal.flush();
+	MAIN->setOutputPaneVisible(true);
+	return missingPages == 0;
+}
+
 bool OutputEditorHOCR::exportToODT() {
 	QString suggestion = m_filebasename;
 	if(suggestion.isEmpty()) {
@@ -1056,7 +1463,9 @@ bool OutputEditorHOCR::exportToODT() {
 
 	ui.treeViewHOCR->setFocus(); // Ensure any item editor loses focus and commits its changes
 	MAIN->getDisplayer()->setBlockAutoscale(true);
+	m_document->blockEviction(true);
 	bool success = HOCROdtExporter().run(m_document, outname);
+	m_document->blockEviction(false);
 	MAIN->getDisplayer()->setBlockAutoscale(false);
 	return success;
 }
@@ -1071,8 +1480,11 @@ bool OutputEditorHOCR::exportToPDF() {
 	if(!showPage(page)) {
 		return false;
 	}
+	// The dialog previews items of the document
+	m_document->blockEviction(true);
 	HOCRPdfExportDialog dialog(m_tool, m_document, page, MAIN);
 	if(dialog.exec() != QDialog::Accepted) {
+		m_document->blockEviction(false);
 		return false;
 	}
 	HOCRPdfExporter::PDFSettings settings = dialog.getPdfSettings();
@@ -1096,12 +1508,14 @@ bool OutputEditorHOCR::exportToPDF() {
 		break;
 	}
 	if(outname.isEmpty()) {
+		m_document->blockEviction(false);
 		return false;
 	}
 
 	MAIN->getDisplayer()->setBlockAutoscale(true);
 	success = HOCRPdfExporter().run(m_document, outname, &settings);
 	MAIN->getDisplayer()->setBlockAutoscale(false);
+	m_document->blockEviction(false);
 	return success;
 }
 
@@ -1119,7 +1533,9 @@ bool OutputEditorHOCR::exportToText() {
 
 	ui.treeViewHOCR->setFocus(); // Ensure any item editor loses focus and commits its changes
 	MAIN->getDisplayer()->setBlockAutoscale(true);
+	m_document->blockEviction(true);
 	bool success = HOCRTextExporter().run(m_document, outname);
+	m_document->blockEviction(false);
 	MAIN->getDisplayer()->setBlockAutoscale(false);
 	return success;
 }
@@ -1144,9 +1560,15 @@ bool OutputEditorHOCR::clear(bool hide) {
 	m_document->clear();
 	ui.tableWidgetProperties->setRowCount(0);
 	ui.plainTextEditOutput->clear();
+	m_sourceIndex = QPersistentModelIndex();
 	m_tool->clearSelection();
 	m_modified = false;
 	m_filebasename.clear();
+	m_journal.discard();
+	m_journalSources.clear();
+	m_journalRevisions.clear();
+	m_journalEditCounts.clear();
+	m_journalLayout.clear();
 	if(hide) {
 		MAIN->setOutputPaneVisible(false);
 	}
@@ -1164,7 +1586,7 @@ void OutputEditorHOCR::onVisibilityChanged(bool /*visible*/) {
 bool OutputEditorHOCR::findReplaceInItem(const QModelIndex& index, const QString& searchstr, const QString& replacestr, bool matchCase, bool backwards, bool replace, bool& currentSelectionMatchesSearch) {
 	// Check that the item is a word
 	const HOCRItem* item = m_document->itemAtIndex(index);
-	if(!item || item->itemClass() != "ocrx_word") {
+	if(!item || item->itemClassId() != HOCRItem::ItemClass::Word) {
 		return false;
 	}
 	Qt::CaseSensitivity cs = matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
@@ -1211,41 +1633,22 @@ bool OutputEditorHOCR::findReplaceInItem(const QModelIndex& index, const QString
 void OutputEditorHOCR::findReplace(const QString& searchstr, const QString& replacestr, bool matchCase, bool backwards, bool replace) {
 	ui.searchFrame->clearErrorState();
 	QModelIndex current = ui.treeViewHOCR->currentIndex();
-	if(!current.isValid()) {
-		current = m_document->index(backwards ? (m_document->rowCount() - 1) : 0, 0);
-	}
-	QModelIndex neww = current;
 	bool currentSelectionMatchesSearch = false;
-	while(!findReplaceInItem(neww, searchstr, replacestr, matchCase, backwards, replace, currentSelectionMatchesSearch)) {
-		neww = backwards ? m_document->prevIndex(neww) : m_document->nextIndex(neww);
-		if(!neww.isValid() || neww == current) {
-			// Break endless loop
-			if(!currentSelectionMatchesSearch) {
-				ui.searchFrame->setErrorState();
-			}
-			return;
+	if(current.isValid() && findReplaceInItem(current, searchstr, replacestr, matchCase, backwards, replace, currentSelectionMatchesSearch)) {
+		return;
+	}
+	// The page text indexes locate the next matching word without walking the items
+	QModelIndex next = m_document->findWord(current, searchstr, matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive, backwards);
+	if(!next.isValid() || !findReplaceInItem(next, searchstr, replacestr, matchCase, backwards, replace, currentSelectionMatchesSearch)) {
+		if(!currentSelectionMatchesSearch) {
+			ui.searchFrame->setErrorState();
 		}
 	}
 }
 
 void OutputEditorHOCR::replaceAll(const QString& searchstr, const QString& replacestr, bool matchCase) {
 	MAIN->pushState(MainWindow::State::Busy, _("Replacing..."));
-	QModelIndex start = m_document->index(0, 0);
-	QModelIndex curr = start;
-	Qt::CaseSensitivity cs = matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
-	int count = 0;
-	do {
-		const HOCRItem* item = m_document->itemAtIndex(curr);
-		if(item && item->itemClass() == "ocrx_word") {
-			if(item->text().contains(searchstr, cs)) {
-				++count;
-				m_document->setData(curr, item->text().replace(searchstr, replacestr, cs), Qt::EditRole);
-			}
-		}
-		curr = m_document->nextIndex(curr);
-		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-	} while(curr != start);
-	if(count == 0) {
+	if(m_document->replaceWordTexts(searchstr, replacestr, matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive) == 0) {
 		ui.searchFrame->setErrorState();
 	}
 	MAIN->popState();
@@ -1253,20 +1656,12 @@ void OutputEditorHOCR::replaceAll(const QString& searchstr, const QString& repla
 
 void OutputEditorHOCR::applySubstitutions(const QMap<QString, QString>& substitutions, bool matchCase) {
 	MAIN->pushState(MainWindow::State::Busy, _("Applying substitutions..."));
-	QModelIndex start = m_document->index(0, 0);
-	Qt::CaseSensitivity cs = matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
-	for(auto it = substitutions.begin(), itEnd = substitutions.end(); it != itEnd; ++it) {
-		QString search = it.key();
-		QString replace = it.value();
-		QModelIndex curr = start;
-		do {
-			const HOCRItem* item = m_document->itemAtIndex(curr);
-			if(item && item->itemClass() == "ocrx_word") {
-				m_document->setData(curr, item->text().replace(search, replace, cs), Qt::EditRole);
-			}
-			curr = m_document->nextIndex(curr);
-			QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-		} while(curr != start);
+	// All substitutions are matched at once in a single pass over the words
+	SubstitutionMatcher matcher(substitutions, matchCase);
+	if(!matcher.isEmpty()) {
+		m_document->editWordTexts([&matcher](QString& text) {
+			return matcher.apply(text) > 0;
+		});
 	}
 	MAIN->popState();
 }
@@ -1314,53 +1709,210 @@ void OutputEditorHOCR::updatePreview() {
 	}
 
 	const HOCRPage* page = item->page();
-	const QRect& bbox = page->bbox();
-	int pageDpi = page->resolution();
-
-	QImage image(bbox.size(), QImage::Format_ARGB32);
-	image.fill(QColor(255, 255, 255, 127));
-	image.setDotsPerMeterX(pageDpi / 0.0254); // 1 in = 0.0254 m
-	image.setDotsPerMeterY(pageDpi / 0.0254);
-	QPainter painter(&image);
-	painter.setRenderHint(QPainter::Antialiasing);
-
-	drawPreview(painter, page);
+	if(page->pageId() != m_previewPageId) {
+		// Keep the preview of the previous page if it is complete. Graphics are crops of the
+		// displayed source image, which can change, so such pages are always rendered again.
+		bool rendering = m_previewWatcher.isRunning() && m_previewJobGeneration == m_previewGeneration;
+		if(!m_previewImage.isNull() && m_previewDirty.isNull() && !rendering && !m_previewHasGraphics) {
+			m_previewCache.insert(m_previewPageId, new QImage(m_previewImage), m_previewImage.sizeInBytes() / 1024);
+		}
+		QImage* cached = m_previewCache.take(page->pageId());
+		m_previewImage = cached ? *cached : QImage();
+		m_previewDirty = cached ? QRect() : page->bbox();
+		delete cached;
+		m_previewPageId = page->pageId();
+		m_previewHasGraphics = false;
+		++m_previewGeneration;
+	}
+	if(!m_previewDirty.isNull()) {
+		// Shown once rendered, a running render of an older state restarts here when finished
+		m_preview->setVisible(false);
+		if(!m_previewWatcher.isRunning()) {
+			startPreviewRender(page);
+		}
+		return;
+	}
 
-	m_preview->setPixmap(QPixmap::fromImage(image));
+	const QRect& bbox = page->bbox();
+	if(m_previewImage.cacheKey() != m_previewPixmapKey) {
+		m_preview->setPixmap(QPixmap::fromImage(m_previewImage));
+		m_previewPixmapKey = m_previewImage.cacheKey();
+	}
 	m_preview->setPos(-0.5 * bbox.width(), -0.5 * bbox.height());
 	m_preview->setVisible(true);
 }
 
-void OutputEditorHOCR::drawPreview(QPainter& painter, const HOCRItem* item) {
+void OutputEditorHOCR::startPreviewRender(const HOCRPage* page) {
+	QRect region = m_previewDirty;
+	m_previewDirty = QRect();
+	QVector<PreviewItem> items;
+	collectPreviewItems(page, region, items, m_previewHasGraphics);
+	QImage image = m_previewImage;
+	QSize size = page->bbox().size();
+	int dpi = page->resolution();
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	if(!QFontDatabase::supportsThreadedFontRendering()) {
+		previewRendered(m_previewGeneration, renderPreview(image, size, dpi, region, items));
+		return;
+	}
+#endif
+	m_previewJobGeneration = m_previewGeneration;
+	m_previewWatcher.setFuture(QtConcurrent::run([ = ] {
+		return renderPreview(image, size, dpi, region, items);
+	}));
+}
+
+void OutputEditorHOCR::previewRendered(int generation, const QImage& image) {
+	// Results for a page which is not current anymore are discarded
+	if(generation == m_previewGeneration) {
+		m_previewImage = image;
+	}
+	updatePreview();
+}
+
+void OutputEditorHOCR::collectPreviewItems(const HOCRItem* item, const QRect& region, QVector<PreviewItem>& items, bool& hasGraphics) const {
 	if(!item->isEnabled()) {
 		return;
 	}
-	QString itemClass = item->itemClass();
-	if(itemClass == "ocr_line") {
-		QPair<double, double> baseline = item->baseLine();
+	HOCRItem::ItemClass itemClass = item->itemClassId();
+	if(itemClass == HOCRItem::ItemClass::Line) {
 		const QRect& lineRect = item->bbox();
+		// Text is not clipped to the word boxes, lines close to the region may draw into it
+		int margin = lineRect.height();
+		if(!lineRect.adjusted(-margin, -margin, margin, margin).intersects(region)) {
+			return;
+		}
+		QPair<double, double> baseline = item->baseLine();
 		for(HOCRItem* wordItem : item->children()) {
 			if(!wordItem->isEnabled()) {
 				continue;
 			}
 			const QRect& wordRect = wordItem->bbox();
-			QFont font;
-			if(!wordItem->fontFamily().isEmpty()) {
-				font.setFamily(wordItem->fontFamily());
-			}
-			font.setBold(wordItem->fontBold());
-			font.setItalic(wordItem->fontItalic());
-			font.setPointSizeF(wordItem->fontSize());
-			painter.setFont(font);
 			// See https://github.com/kba/hocr-spec/issues/15
 			double y = lineRect.bottom() + (wordRect.center().x() - lineRect.x()) * baseline.first + baseline.second;
-			painter.drawText(wordRect.x(), y, wordItem->text());
+			items.append({wordRect, QPoint(wordRect.x(), y), wordItem->text(), wordItem->fontFamily(), wordItem->fontSize(), wordItem->fontBold(), wordItem->fontItalic(), QImage()});
+		}
+	} else if(itemClass == HOCRItem::ItemClass::Graphic) {
+		hasGraphics = true;
+		if(item->bbox().intersects(region)) {
+			items.append({item->bbox(), QPoint(), QString(), QString(), 0., false, false, m_tool->getSelection(item->bbox())});
 		}
-	} else if(itemClass == "ocr_graphic") {
-		painter.drawImage(item->bbox(), m_tool->getSelection(item->bbox()));
 	} else {
 		for(HOCRItem* childItem : item->children()) {
-			drawPreview(painter, childItem);;
+			collectPreviewItems(childItem, region, items, hasGraphics);
+		}
+	}
+}
+
+QImage OutputEditorHOCR::renderPreview(QImage image, const QSize& size, int dpi, const QRect& region, const QVector<PreviewItem>& items) {
+	if(image.isNull()) {
+		image = QImage(size, QImage::Format_ARGB32);
+		image.setDotsPerMeterX(dpi / 0.0254); // 1 in = 0.0254 m
+		image.setDotsPerMeterY(dpi / 0.0254);
+	}
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.setClipRect(region);
+	painter.setCompositionMode(QPainter::CompositionMode_Source);
+	painter.fillRect(region, QColor(255, 255, 255, 127));
+	painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+	// Fonts by (family, (size, bold | italic)), most words of a page share a handful of them
+	typedef QPair<QString, QPair<double, int>> FontKey;
+	QHash<FontKey, QFont> fonts;
+	FontKey currentFont;
+	bool haveFont = false;
+	for(const PreviewItem& item : items) {
+		if(!item.graphic.isNull()) {
+			painter.drawImage(item.bbox, item.graphic);
+			continue;
+		}
+		FontKey key = qMakePair(item.fontFamily, qMakePair(item.fontSize, int(item.bold) | int(item.italic) << 1));
+		if(!haveFont || key != currentFont) {
+			auto it = fonts.find(key);
+			if(it == fonts.end()) {
+				QFont font;
+				if(!item.fontFamily.isEmpty()) {
+					font.setFamily(item.fontFamily);
+				}
+				font.setBold(item.bold);
+				font.setItalic(item.italic);
+				font.setPointSizeF(item.fontSize);
+				it = fonts.insert(key, font);
+			}
+			painter.setFont(it.value());
+			currentFont = key;
+			haveFont = true;
+		}
+		painter.drawText(item.pos, item.text);
+	}
+	return image;
+}
+
+void OutputEditorHOCR::invalidatePreview(const HOCRItem* item, bool wholePage) {
+	if(!item) {
+		return;
+	}
+	const HOCRPage* page = item->page();
+	if(page->pageId() != m_previewPageId) {
+		m_previewCache.remove(page->pageId());
+		return;
+	}
+	QRect rect = page->bbox();
+	if(!wholePage) {
+		// Redraw the whole line of a word, the neighbouring words may overlap it
+		const HOCRItem* line = item->itemClassId() == HOCRItem::ItemClass::Word && item->parent() ? item->parent() : item;
+		rect = line->bbox();
+	}
+	m_previewDirty = m_previewDirty.united(rect);
+}
+
+void OutputEditorHOCR::resetPreview() {
+	m_previewCache.clear();
+	m_previewImage = QImage();
+	m_previewPageId = -1;
+	m_previewDirty = QRect();
+	m_previewHasGraphics = false;
+	++m_previewGeneration;
+}
+
+void OutputEditorHOCR::previewDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles) {
+	// Only the text and the enabled state are visible in the preview, not i.e. the spelling or the page titles
+	bool checkState = roles.contains(Qt::CheckStateRole);
+	if(topLeft.column() > 0 || (!roles.isEmpty() && !checkState && !roles.contains(Qt::DisplayRole)) || (!topLeft.parent().isValid() && !checkState)) {
+		return;
+	}
+	if(topLeft.parent() != bottomRight.parent()) {
+		invalidatePreview(m_document->itemAtIndex(topLeft));
+		return;
+	}
+	for(int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+		invalidatePreview(m_document->itemAtIndex(topLeft.sibling(row, 0)));
+	}
+}
+
+void OutputEditorHOCR::previewRowsInserted(const QModelIndex& parent, int first, int last) {
+	// New pages have no preview yet
+	if(!parent.isValid()) {
+		return;
+	}
+	for(int row = first; row <= last; ++row) {
+		invalidatePreview(m_document->itemAtIndex(m_document->index(row, 0, parent)));
+	}
+}
+
+void OutputEditorHOCR::previewRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last) {
+	for(int row = first; row <= last; ++row) {
+		const HOCRItem* item = m_document->itemAtIndex(m_document->index(row, 0, parent));
+		if(parent.isValid()) {
+			invalidatePreview(item);
+		} else if(item->page()->pageId() == m_previewPageId) {
+			m_previewImage = QImage();
+			m_previewPageId = -1;
+			m_previewDirty = QRect();
+			++m_previewGeneration;
+		} else {
+			m_previewCache.remove(item->page()->pageId());
 		}
 	}
 }
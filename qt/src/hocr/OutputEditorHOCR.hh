@@ -20,8 +20,12 @@
 #ifndef OUTPUTEDITORHOCR_HH
 #define OUTPUTEDITORHOCR_HH
 
+#include <QCache>
+#include <QFutureWatcher>
+#include <QImage>
 #include <QTimer>
 
+#include "EditJournal.hh"
 #include "OutputEditor.hh"
 #include "Ui_OutputEditorHOCR.hh"
 
@@ -58,6 +62,7 @@ public:
 	BatchProcessor* createBatchProcessor(const QMap<QString, QVariant>& /*options*/) const override { return new HOCRBatchProcessor; }
 	bool containsSource(const QString& source, int sourcePage) const override;
 	bool crashSave(const QString& filename) const override;
+	bool recoverJournal(const QString& session, QString& error) override;
 
 	HOCRDocument* getDocument() const { return m_document; }
 	DisplayerToolHOCR* getTool() const { return m_tool; }
@@ -77,11 +82,30 @@ public slots:
 
 private:
 	class HTMLHighlighter;
+	class OpenProgressMonitor;
 
 	struct HOCRReadSessionData : ReadSessionData {
 		int insertIndex;
 		QStringList errors;
 	};
+	// Snapshot of a word or graphic to draw in the preview, taken so that rendering can happen off the GUI thread
+	struct PreviewItem {
+		QRect bbox;
+		QPoint pos;
+		QString text;
+		QString fontFamily;
+		double fontSize;
+		bool bold;
+		bool italic;
+		QImage graphic;
+	};
+	// The journal records the files unmodified pages can be read from again, the state of modified pages, the edits of
+	// items since and the page order. Its snapshots consist of the records which are not superseded by later ones.
+	enum JournalRecord : quint8 { JournalSource = 1, JournalPage, JournalLayout, JournalEdit };
+	struct JournalSourceFile {
+		QString filename;
+		QVector<int> pageIds;
+	};
 	friend struct QMetaTypeId<HOCRReadSessionData>;
 
 	DisplayerToolHOCR* m_tool;
@@ -89,12 +113,32 @@ private:
 	QGraphicsPixmapItem* m_preview = nullptr;
 	HOCRProofReadWidget* m_proofReadWidget = nullptr;
 	QTimer m_previewTimer;
+	// Preview of the current page, only the regions touched by edits are rendered again.
+	// Complete previews of previously shown pages are cached, in KiB.
+	QImage m_previewImage;
+	int m_previewPageId = -1;
+	QRect m_previewDirty;
+	bool m_previewHasGraphics = false;
+	int m_previewGeneration = 0;
+	int m_previewJobGeneration = -1;
+	qint64 m_previewPixmapKey = 0;
+	QCache<int, QImage> m_previewCache;
+	QFutureWatcher<QImage> m_previewWatcher;
 	UI_OutputEditorHOCR ui;
 	HTMLHighlighter* m_highlighter;
+	// Item whose source is shown, invalid if the source needs to be regenerated
+	QPersistentModelIndex m_sourceIndex;
 	bool m_modified = false;
 	bool m_blockSourceChanged = false;
 	QString m_filebasename;
 	InsertMode m_insertMode = InsertMode::Append;
+	EditJournal m_journal;
+	QVector<JournalSourceFile> m_journalSources;
+	// Revisions of the pages as restored by replaying the journal
+	QHash<int, quint32> m_journalRevisions;
+	// Number of edits journaled since the page was journaled as a whole
+	QHash<int, int> m_journalEditCounts;
+	QVector<int> m_journalLayout;
 
 	HOCRDocument* m_document;
 
@@ -105,7 +149,16 @@ private:
 	bool findReplaceInItem(const QModelIndex& index, const QString& searchstr, const QString& replacestr, bool matchCase, bool backwards, bool replace, bool& currentSelectionMatchesSearch);
 	bool showPage(const HOCRPage* page);
 	int currentPage();
-	void drawPreview(QPainter& painter, const HOCRItem* item);
+	void collectPreviewItems(const HOCRItem* item, const QRect& region, QVector<PreviewItem>& items, bool& hasGraphics) const;
+	static QImage renderPreview(QImage image, const QSize& size, int dpi, const QRect& region, const QVector<PreviewItem>& items);
+	void startPreviewRender(const HOCRPage* page);
+	void previewRendered(int generation, const QImage& image);
+	void invalidatePreview(const HOCRItem* item, bool wholePage = false);
+	void resetPreview();
+	void journalAppend(JournalRecord type, const std::function<void(QDataStream&)>& write);
+	bool readJournalSource(const QString& filename, const QList<Config::Lang>& langSpecs, QVector<HOCRPage*>& pages);
+	void journalItemEdit(const HOCRPage* page, quint32 revision, const HOCRDocument::ItemEdit& edit);
+	static QByteArray compactJournalRecords(const QByteArray& snapshot, const QVector<EditJournal::Record>& journal);
 
 private slots:
 	void bboxDrawn(const QRect& bbox, int action);
@@ -139,6 +192,11 @@ private slots:
 	void sourceChanged();
 	void previewToggled(bool active);
 	void updatePreview();
+	void previewDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+	void previewRowsInserted(const QModelIndex& parent, int first, int last);
+	void previewRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+	void updateJournal();
+	void compactJournal();
 };
 
 class HOCRAttributeEditor : public QLineEdit {